@@ -22,6 +22,7 @@
  */
 
 #include <math.h>
+#include <string.h>
 
 #include <oscpod.h>
 #include <eeprom.h>
@@ -36,12 +37,99 @@ uint_fast8_t calibrating = 0;
 
 uint16_t arr [SENSOR_N];
 static Calibration_Point point [SENSOR_N];
+static float crosstalk [SENSOR_N][SENSOR_N]; // measured mixing matrix, column per actuated valve
+
+// identity, no compensation
+static void
+crosstalk_reset()
+{
+	uint_fast8_t i, j;
+
+	for(i=0; i<SENSOR_N; i++)
+		for(j=0; j<CROSSTALK_STRIDE; j++)
+			range.X[i][j] = i == j ? CROSSTALK_ONE : 0;
+}
+
+static void
+crosstalk_start()
+{
+	uint_fast8_t i, j;
+
+	for(i=0; i<SENSOR_N; i++)
+		for(j=0; j<SENSOR_N; j++)
+			crosstalk[i][j] = i == j ? 1.f : 0.f;
+}
+
+// measure bleed of a single fully pressed valve into all other sensors
+static uint_fast8_t
+crosstalk_measure(uint_fast8_t valve)
+{
+	float v [SENSOR_N];
+	uint_fast8_t j;
+
+	for(j=0; j<SENSOR_N; j++)
+		v[j] = (adc_filt[j].OO1 - adc_drift[j] - range.Bmin[j]) * range.W[j];
+
+	if(v[valve] < 0.5f) // valve not pressed enough for a meaningful ratio
+		return 0;
+
+	for(j=0; j<SENSOR_N; j++)
+		if( (j != valve) && (j != SENSOR_BREATH) )
+			crosstalk[j][valve] = v[j] / v[valve];
+
+	return 1;
+}
+
+// compensation matrix is the inverse of the measured mixing matrix
+static uint_fast8_t
+crosstalk_fit()
+{
+	float A [SENSOR_N][SENSOR_N];
+	float B [SENSOR_N][SENSOR_N];
+	uint_fast8_t i, j;
+
+	memcpy(A, crosstalk, sizeof(A));
+	if(!linalg_invert(&A[0][0], &B[0][0], SENSOR_N))
+		return 0;
+
+	for(i=0; i<SENSOR_N; i++)
+		for(j=0; j<SENSOR_N; j++)
+			if(fabsf(B[i][j]) >= 2.f) // not representable in Q14
+				return 0;
+
+	for(i=0; i<SENSOR_N; i++)
+		for(j=0; j<SENSOR_N; j++)
+			range.X[i][j] = lrintf(B[i][j] * CROSSTALK_ONE);
+
+	return 1;
+}
+
+// ranges saved before the matrix existed carry garbage in its place
+static uint_fast8_t
+crosstalk_valid()
+{
+	uint_fast8_t i, j;
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		if(range.X[i][i] <= 0) // a fitted inverse keeps a positive diagonal
+			return 0;
+		for(j=SENSOR_N; j<CROSSTALK_STRIDE; j++)
+			if(range.X[i][j] != 0) // padding must stay zero
+				return 0;
+	}
+
+	return 1;
+}
 
 uint_fast8_t
 range_load(uint_fast8_t pos)
 {
 	eeprom_bulk_read(eeprom_24LC64, EEPROM_RANGE_OFFSET + pos*EEPROM_RANGE_SIZE,(uint8_t *)&range, sizeof(range));
 
+	if(!crosstalk_valid())
+		crosstalk_reset();
+
 	return 1;
 }
 
@@ -60,6 +148,8 @@ range_reset()
 		range.C[i][2] = 0.f; // ~ x
 	}
 
+	crosstalk_reset();
+
 	return 1;
 }
 
@@ -251,6 +341,7 @@ _calibration_start(const char *path, const char *fmt, uint_fast8_t argc, osc_dat
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
 
 	range_init();
+	autozero_reset(); // measured anew
 
 	// enable calibration
 	zeroing = 1;
@@ -276,6 +367,7 @@ _calibration_zero(const char *path, const char *fmt, uint_fast8_t argc, osc_data
 		// update new range
 		zeroing = 0;
 		range_update_quiescent();
+		autozero_reset(); // drift was relative to the old quiescent level
 		size = CONFIG_SUCCESS("is", uuid, path);
 	}
 	else
@@ -419,6 +511,82 @@ _calibration_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_dat
 	return 1;
 }
 
+static uint_fast8_t
+_calibration_crosstalk_start(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	crosstalk_start();
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_calibration_crosstalk_valve(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+	int32_t valve;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+	buf_ptr = osc_get_int32(buf_ptr, &valve);
+
+	if( (valve < 0) || (valve >= SENSOR_BREATH) )
+		size = CONFIG_FAIL("iss", uuid, path, "not a valve");
+	else if(crosstalk_measure(valve))
+		size = CONFIG_SUCCESS("is", uuid, path);
+	else
+		size = CONFIG_FAIL("iss", uuid, path, "valve must be fully pressed");
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_calibration_crosstalk_fit(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(crosstalk_fit())
+		size = CONFIG_SUCCESS("is", uuid, path);
+	else
+		size = CONFIG_FAIL("iss", uuid, path, "crosstalk matrix not invertible");
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_calibration_crosstalk_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	crosstalk_reset();
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
 /*
  * Query
  */
@@ -435,6 +603,17 @@ static const OSC_Query_Argument calibration_mid_args [] = {
 	OSC_QUERY_ARGUMENT_FLOAT("Relative vicinity", OSC_QUERY_MODE_W, 0.f, 1.f, 0.01)
 };
 
+static const OSC_Query_Argument calibration_crosstalk_valve_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Pressed valve", OSC_QUERY_MODE_W, 0, SENSOR_BREATH - 1, 1)
+};
+
+static const OSC_Query_Item calibration_crosstalk_tree [] = {
+	OSC_QUERY_ITEM_METHOD("start", "Start crosstalk measurement", _calibration_crosstalk_start, NULL),
+	OSC_QUERY_ITEM_METHOD("valve", "Measure while only given valve is fully pressed", _calibration_crosstalk_valve, calibration_crosstalk_valve_args),
+	OSC_QUERY_ITEM_METHOD("fit", "Fit compensation matrix to measurements", _calibration_crosstalk_fit, NULL),
+	OSC_QUERY_ITEM_METHOD("reset", "Disable crosstalk compensation", _calibration_crosstalk_reset, NULL)
+};
+
 const OSC_Query_Item calibration_tree [] = {
 	OSC_QUERY_ITEM_METHOD("load", "Load calibration from EEPROM", _calibration_load, calibration_load_args),
 	OSC_QUERY_ITEM_METHOD("save", "Save calibration to EEPROM", _calibration_save, calibration_save_args),
@@ -444,5 +623,7 @@ const OSC_Query_Item calibration_tree [] = {
 	OSC_QUERY_ITEM_METHOD("zero", "Calibrate quiescent values", _calibration_zero, NULL),
 	OSC_QUERY_ITEM_METHOD("min", "Calibrate threshold values / curve fit point 1", _calibration_min, NULL),
 	OSC_QUERY_ITEM_METHOD("mid", "Curve fit points 2-4", _calibration_mid, calibration_mid_args),
-	OSC_QUERY_ITEM_METHOD("max", "Curve fit point 5", _calibration_max, NULL)
+	OSC_QUERY_ITEM_METHOD("max", "Curve fit point 5", _calibration_max, NULL),
+
+	OSC_QUERY_ITEM_NODE("crosstalk/", "Magnetic crosstalk compensation", calibration_crosstalk_tree)
 };
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#include <string.h>
+
+#include <oscpod.h>
+#include <config.h>
+#include <utility.h>
+#include <calibration.h>
+#include <capture.h>
+
+// globals
+uint8_t capturing = 0;
+
+static uint_fast8_t capture_range_pending = 0;
+static uint_fast8_t capture_n = 0;
+static osc_data_t capture_buf [CAPTURE_BATCH * CAPTURE_RECORD_SIZE] __attribute__((aligned(4)));
+
+void __CCM_TEXT__
+capture_frame(int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	osc_data_t *buf_ptr;
+
+	if(capture_n >= CAPTURE_BATCH) // previous batch not yet flushed
+		return;
+
+	buf_ptr = capture_buf + capture_n*CAPTURE_RECORD_SIZE;
+	buf_ptr = osc_set_int32(buf_ptr, frm);
+	buf_ptr = osc_set_timetag(buf_ptr, now);
+	buf_ptr = osc_set_timetag(buf_ptr, offset);
+	for(i=0; i<SENSOR_N; i++, buf_ptr+=2)
+		ref_hton(buf_ptr, adc_raw[i]);
+	memset(buf_ptr, 0, capture_buf + (capture_n+1)*CAPTURE_RECORD_SIZE - buf_ptr); // zero padding
+
+	capture_n++;
+}
+
+static osc_data_t *
+_capture_start(osc_data_t *buf, osc_data_t **preamble)
+{
+	if(config.debug.osc.mode == OSC_MODE_TCP)
+		return osc_start_bundle_item(buf, preamble);
+	else
+		return buf;
+}
+
+static void
+_capture_send(osc_data_t *buf, osc_data_t *buf_ptr, osc_data_t *preamble)
+{
+	if(config.debug.osc.mode == OSC_MODE_TCP)
+		buf_ptr = osc_end_bundle_item(buf_ptr, preamble);
+
+	uint16_t size = buf_ptr - buf;
+	if(config.debug.osc.mode == OSC_MODE_SLIP)
+		size = slip_encode(buf, size);
+
+	osc_send(&config.debug.osc, BUF_O_BASE(buf_o_ptr), size);
+}
+
+void
+capture_flush()
+{
+	osc_data_t *buf = BUF_O_OFFSET(buf_o_ptr);
+	osc_data_t *buf_ptr;
+	osc_data_t *preamble;
+
+	if(!config.debug.osc.socket.enabled || (wiz_socket_state[SOCK_DEBUG] != WIZ_SOCKET_STATE_OPEN) )
+		return;
+
+	// calibration is needed to replay the captured frames
+	if(capture_range_pending)
+	{
+		buf_ptr = _capture_start(buf, &preamble);
+		buf_ptr = osc_set_path(buf_ptr, "/capture/range");
+		buf_ptr = osc_set_fmt(buf_ptr, "b");
+		buf_ptr = osc_set_blob(buf_ptr, sizeof(Calibration), &range);
+		_capture_send(buf, buf_ptr, preamble);
+
+		capture_range_pending = 0;
+	}
+
+	if(capture_n == CAPTURE_BATCH)
+	{
+		buf_ptr = _capture_start(buf, &preamble);
+		buf_ptr = osc_set_path(buf_ptr, "/capture/frames");
+		buf_ptr = osc_set_fmt(buf_ptr, "ib");
+		buf_ptr = osc_set_int32(buf_ptr, SENSOR_N);
+
+		if(config.debug.osc.mode == OSC_MODE_SLIP) // needs the whole packet for encoding
+		{
+			buf_ptr = osc_set_blob(buf_ptr, sizeof(capture_buf), capture_buf);
+			_capture_send(buf, buf_ptr, preamble);
+		}
+		else // gather header and records straight into the TX buffer, no staging copy
+		{
+			buf_ptr = osc_set_int32(buf_ptr, sizeof(capture_buf)); // blob size, records are 4-byte aligned
+			if(config.debug.osc.mode == OSC_MODE_TCP)
+				osc_set_int32(preamble, buf_ptr - (preamble+4) + sizeof(capture_buf));
+
+			const Wiz_Vec vec [2] = {
+				{buf, buf_ptr - buf},
+				{capture_buf, sizeof(capture_buf)}
+			};
+			osc_sendv(&config.debug.osc, vec, 2);
+		}
+
+		capture_n = 0;
+	}
+}
+
+/*
+ * Config
+ */
+
+static uint_fast8_t
+_capture_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &capturing);
+
+	if(capturing && (argc > 1) ) // (re)start capture
+	{
+		capture_n = 0;
+		capture_range_pending = 1;
+	}
+
+	return res;
+}
+
+/*
+ * Query
+ */
+
+const OSC_Query_Item capture_tree [] = {
+	OSC_QUERY_ITEM_METHOD("enabled", "Stream raw sensor frames to debug socket", _capture_enabled, config_boolean_args)
+};
@@ -23,6 +23,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <math.h>
 
 #include <oscpod.h>
@@ -37,6 +38,7 @@
 #include <mdns-sd.h>
 #include <debug.h>
 #include <calibration.h>
+#include <capture.h>
 
 static char string_buf [64];
 const char *success_str = "/success";
@@ -65,6 +67,7 @@ Config config = {
 		.minor = VERSION_MINOR,
 		.patch = VERSION_PATCH
 	},
+	.layout = sizeof(Config),
 
 	.name = {'s', 'p', 'a', 'c', 'e', '_', 'w', 'h', 'i', 's', 't', 'l', 'e', '\0'},
 
@@ -74,6 +77,7 @@ Config config = {
 		.ip = {192, 168, 1, 188},
 		.gateway = {192, 168, 1, 0},
 		.subnet = {255, 255, 255, 0},
+		.spi_adapt = 0
 	},
 	
 	.output = {
@@ -92,7 +96,17 @@ Config config = {
 			.x = 0,
 			.z = 0
 		},
-		.parallel = 1
+		.parallel = 1,
+		.engine = ENGINE_DUMP_RAW,
+		.midi = MIDI_CONFIG_DEFAULT,
+		.packed_q15 = 0,
+		.packed_fec = 0,
+		.fingering = FINGERING_CONFIG_DEFAULT,
+		.batch = {
+			.frames = 1,
+			.latency = 0.004ULLK // := 4ms
+		},
+		.queue = 0
 	},
 
 	.config = {
@@ -173,7 +187,11 @@ Config config = {
 
 	.sensors = {
 		.movingaverage_bitshift = 3,
-		.rate = 2000
+		.rate = 2000,
+		.valve_divider = 1,
+		.phase_lock = 1,
+		.breath = BREATH_CONFIG_DEFAULT,
+		.autozero = AUTOZERO_CONFIG_DEFAULT
 	}
 };
 
@@ -230,20 +248,33 @@ uint_fast8_t
 version_match()
 {
 	Firmware_Version version;
+	uint16_t layout;
 	eeprom_bulk_read(eeprom_24LC64, EEPROM_CONFIG_OFFSET,(uint8_t *)&version, sizeof(Firmware_Version));
+	eeprom_bulk_read(eeprom_24LC64, EEPROM_CONFIG_OFFSET + offsetof(Config, layout),(uint8_t *)&layout, sizeof(layout));
 
-	// check whether EEPROM and FLASH version numbers match
+	// check whether EEPROM and FLASH version numbers and config layouts match
 	// board revision is excluded from the check
 	return(version.major == config.version.major)
 		&& (version.minor == config.version.minor)
-		&& (version.patch == config.version.patch);
+		&& (version.patch == config.version.patch)
+		&& (layout == config.layout);
 }
 
 uint_fast8_t
 config_load()
 {
 	if(version_match())
+	{
 		eeprom_bulk_read(eeprom_24LC64, EEPROM_CONFIG_OFFSET,(uint8_t *)&config, sizeof(config));
+
+		// engine indexes a callback table, never trust the stored value
+		if(config.output.engine >= ENGINE_N)
+			config.output.engine = ENGINE_DUMP_RAW;
+
+		// FEC parity must never share a datagram with the frames of its group
+		if(config.output.batch.frames > 1)
+			config.output.packed_fec = 0;
+	}
 	else // EEPROM and FLASH config version do not match, overwrite old with new default one
 		config_save();
 
@@ -834,6 +865,113 @@ _host_address_dns_cb(uint8_t *ip, void *data)
 		CONFIG_SEND(size);
 }
 
+static uint_fast8_t
+_comm_sockets(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+	int32_t i;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+	buf_ptr = osc_get_int32(buf_ptr, &i);
+
+	if( (i < 0) || (i >= WIZ_MAX_SOCK_NUM) )
+		size = CONFIG_FAIL("iss", uuid, path, "socket out of range");
+	else if(argc == 2) // query
+	{
+		uint8_t tx_mem [WIZ_MAX_SOCK_NUM];
+		uint8_t rx_mem [WIZ_MAX_SOCK_NUM];
+		wiz_sockets_get(tx_mem, rx_mem);
+		size = CONFIG_SUCCESS("isiii", uuid, path, i, tx_mem[i], rx_mem[i]);
+	}
+	else // split follows the enabled services
+		size = CONFIG_FAIL("iss", uuid, path, "read-only");
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_spi_adaptive(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.comm.spi_adapt);
+
+	if(argc > 1)
+		wiz_spi_adapt(config.comm.spi_adapt);
+
+	return res;
+}
+
+static uint_fast8_t
+_spi_divider(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	size = CONFIG_SUCCESS("isi", uuid, path, wiz_spi_divider());
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_spi_traffic(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	// copy first, the reply itself is clocked over the bus
+	Wiz_SPI_Stats stats = wiz_spi_stats;
+	uint32_t busy = stats.cycles / (SNTP_SYSTICK_CYCLES / SNTP_SYSTICK_US); // in us
+
+	size = CONFIG_SUCCESS("isiii", uuid, path, stats.frames, stats.bytes, busy);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_spi_errors(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	Wiz_SPI_Stats stats = wiz_spi_stats;
+
+	size = CONFIG_SUCCESS("isiiii", uuid, path, stats.dma_err, stats.ovr, stats.modf, stats.dropped);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_spi_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	wiz_spi_stats_reset();
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
 static uint_fast8_t
 _comm_address(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
@@ -933,142 +1071,527 @@ _output_parallel(const char *path, const char *fmt, uint_fast8_t argc, osc_data_
 }
 
 static uint_fast8_t
-_reset_soft(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+_output_queue(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.output.queue);
+}
+
+static const OSC_Query_Value engines_engine_args_values [] = {
+	[ENGINE_DUMP_RAW]	= { .s = "dump_raw" },
+	[ENGINE_DUMP_VAL]	= { .s = "dump_val" },
+	[ENGINE_LOSSLESS]	= { .s = "lossless" },
+	[ENGINE_LOSSY]		= { .s = "lossy" },
+	[ENGINE_MIDI]			= { .s = "midi" },
+	[ENGINE_PACKED]		= { .s = "packed" },
+	[ENGINE_FINGERING]	= { .s = "fingering" }
+};
+
+static uint_fast8_t
+_config_string_value(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf,
+	const OSC_Query_Value *values, uint_fast8_t n, uint8_t *val)
 {
 	osc_data_t *buf_ptr = buf;
 	uint16_t size;
 	int32_t uuid;
 
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
-	int32_t sec;
 
-	size = CONFIG_SUCCESS("is", uuid, path);
+	if(argc == 1) // query
+	{
+		if(*val < n)
+			size = CONFIG_SUCCESS("iss", uuid, path, values[*val].s);
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "invalid value");
+	}
+	else
+	{
+		uint_fast8_t i;
+		const char *s;
+		buf_ptr = osc_get_string(buf_ptr, &s);
+		for(i=0; i<n; i++)
+			if(!strcmp(s, values[i].s))
+				break;
+		if(i < n)
+		{
+			*val = i;
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "unknown value");
+	}
+
 	CONFIG_SEND(size);
 
-	// reset factory reset flag
-	bkp_enable_writes();
-	bkp_write(RESET_MODE_REG, RESET_MODE_FLASH_SOFT);
-	bkp_disable_writes();
+	return 1;
+}
 
-	nvic_sys_reset();
+static uint_fast8_t
+_output_engine(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = _config_string_value(path, fmt, argc, buf, engines_engine_args_values,
+		ENGINE_N, &config.output.engine);
 
-	return 1;
+	if(argc > 1)
+		output_batch_reset(0);
+
+	return res;
+}
+
+static const OSC_Query_Value midi_mode_args_values [] = {
+	[MIDI_MODE_CC]	= { .s = "cc" },
+	[MIDI_MODE_MPE]	= { .s = "mpe" }
+};
+
+static uint_fast8_t
+_midi_mode(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = _config_string_value(path, fmt, argc, buf, midi_mode_args_values,
+		sizeof(midi_mode_args_values)/sizeof(OSC_Query_Value), &config.output.midi.mode);
+
+	if(argc > 1)
+		midi_configure(&config.output.midi);
+
+	return res;
 }
 
 static uint_fast8_t
-_reset_hard(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+_midi_channel(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
 {
 	osc_data_t *buf_ptr = buf;
 	uint16_t size;
 	int32_t uuid;
 
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
-	int32_t sec;
-
-	size = CONFIG_SUCCESS("is", uuid, path);
-	CONFIG_SEND(size);
 
-	// set factory reset flag
-	bkp_enable_writes();
-	bkp_write(RESET_MODE_REG, RESET_MODE_FLASH_HARD);
-	bkp_disable_writes();
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isi", uuid, path, config.output.midi.channel);
+	else
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		if( (i >= 0) && (i <= 0xf) )
+		{
+			config.output.midi.channel = i;
+			midi_configure(&config.output.midi);
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "channel out of range");
+	}
 
-	nvic_sys_reset();
+	CONFIG_SEND(size);
 
 	return 1;
 }
 
 static uint_fast8_t
-_reset_flash(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+_midi_map(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, uint8_t *map, uint8_t max)
 {
 	osc_data_t *buf_ptr = buf;
 	uint16_t size;
 	int32_t uuid;
+	int32_t i;
 
 	buf_ptr = osc_get_int32(buf_ptr, &uuid);
-	int32_t sec;
-
-	size = CONFIG_SUCCESS("is", uuid, path);
-	CONFIG_SEND(size);
+	buf_ptr = osc_get_int32(buf_ptr, &i);
 
-	// set bootloader flag
-	bkp_enable_writes();
-	bkp_write(RESET_MODE_REG, RESET_MODE_SYSTEM_FLASH);
-	bkp_disable_writes();
+	if( (i < 0) || (i >= SENSOR_N) )
+		size = CONFIG_FAIL("iss", uuid, path, "sensor out of range");
+	else if(argc == 2) // query
+		size = CONFIG_SUCCESS("isii", uuid, path, i, map[i]);
+	else
+	{
+		int32_t v;
+		buf_ptr = osc_get_int32(buf_ptr, &v);
+		if( (v >= 0) && (v <= max) )
+		{
+			map[i] = v;
+			midi_configure(&config.output.midi);
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "value out of range");
+	}
 
-	nvic_sys_reset();
+	CONFIG_SEND(size);
 
 	return 1;
 }
 
-static uint_fast8_t _query(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf);
-
-// globals
-const OSC_Method config_serv [] = {
-	{NULL, NULL, _query},
-	{NULL, NULL, NULL} // terminator
-};
+static uint_fast8_t
+_midi_cc(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _midi_map(path, fmt, argc, buf, config.output.midi.cc, 0x1f);
+}
 
-const OSC_Query_Value config_mode_args_values [] = {
-	[OSC_MODE_UDP]	= { .s = "osc.udp" },
-	[OSC_MODE_TCP]	= { .s = "osc.tcp" },
-	[OSC_MODE_SLIP]	= { .s = "osc.slip.tcp" }
-};
+static uint_fast8_t
+_midi_note(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _midi_map(path, fmt, argc, buf, config.output.midi.note, 0x7f);
+}
 
-const OSC_Query_Argument config_mode_args [] = {
-	OSC_QUERY_ARGUMENT_STRING_VALUES("mode", OSC_QUERY_MODE_RW, config_mode_args_values)
-};
+static uint_fast8_t
+_packed_q15(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_bool(path, fmt, argc, buf, &config.output.packed_q15);
 
-// global arguments
-const OSC_Query_Argument config_boolean_args [] = {
-	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
-};
+	if(argc > 1)
+		packed_configure(config.output.packed_q15, config.output.packed_fec);
 
-const OSC_Query_Argument config_address_args [] = {
-	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted or mDNS .local domain with colon and port", OSC_QUERY_MODE_RW, 64)
-};
+	return res;
+}
 
-// locals
-static const OSC_Query_Argument comm_mac_args [] = {
-	OSC_QUERY_ARGUMENT_STRING("EUI-48 hexadecimal colon", OSC_QUERY_MODE_RW, 17)
-};
+// FEC parity must never share a datagram with the frames of its group
+static uint_fast8_t
+_packed_fec(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
 
-static const OSC_Query_Argument comm_ip_args [] = {
-	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted CIDR", OSC_QUERY_MODE_RW, 18)
-};
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
 
-static const OSC_Query_Argument comm_gateway_args [] = {
-	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted or mDNS .local domain", OSC_QUERY_MODE_RW, 64)
-};
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isi", uuid, path, config.output.packed_fec);
+	else
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		if( (i < 0) || (i > PACKED_FEC_MAX) )
+			size = CONFIG_FAIL("iss", uuid, path, "group size out of range");
+		else if( (i > 0) && (config.output.batch.frames > 1) )
+			size = CONFIG_FAIL("iss", uuid, path, "FEC needs batching disabled");
+		else
+		{
+			config.output.packed_fec = i;
+			packed_configure(config.output.packed_q15, config.output.packed_fec);
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+	}
 
-static const OSC_Query_Argument comm_address_args [] = {
-	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted or mDNS .local domain", OSC_QUERY_MODE_W, 64)
-};
+	CONFIG_SEND(size);
 
-const OSC_Query_Item comm_tree [] = {
-	OSC_QUERY_ITEM_METHOD("mac", "Hardware MAC address", _comm_mac, comm_mac_args),
-	OSC_QUERY_ITEM_METHOD("ip", "IPv4 client address", _comm_ip, comm_ip_args),
-	OSC_QUERY_ITEM_METHOD("gateway", "IPv4 gateway address", _comm_gateway, comm_gateway_args),
-	OSC_QUERY_ITEM_METHOD("address", "Shared remote IPv4 address", _comm_address, comm_address_args),
-};
+	return 1;
+}
 
-const OSC_Query_Item config_tree [] = {
-	OSC_QUERY_ITEM_METHOD("save", "Save to EEPROM", _config_save, NULL),
-	OSC_QUERY_ITEM_METHOD("load", "Load from EEPROM", _config_load, NULL),
-	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable socket", _config_enabled, config_boolean_args),
-	OSC_QUERY_ITEM_METHOD("address", "Single remote IPv4 address", _config_address, config_address_args),
-	OSC_QUERY_ITEM_METHOD("mode", "Enable/disable UDP/TCP mode", _config_mode, config_mode_args)
-};
+static uint_fast8_t
+_batch_frames(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
 
-const OSC_Query_Item reset_tree [] = {
-	OSC_QUERY_ITEM_METHOD("soft", "Soft reset", _reset_soft, NULL),
-	OSC_QUERY_ITEM_METHOD("hard", "Hard reset", _reset_hard, NULL),
-	OSC_QUERY_ITEM_METHOD("flash", "Reset into flash mode", _reset_flash, NULL),
-};
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
 
-static const OSC_Query_Argument info_version_args [] = {
-	OSC_QUERY_ARGUMENT_STRING("{Major}.{Minor}.{Patch level}-{Board revision}", OSC_QUERY_MODE_R, 32)
-};
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isi", uuid, path, config.output.batch.frames);
+	else
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		if( (i < 0) || (i > 0xff) )
+			size = CONFIG_FAIL("iss", uuid, path, "frames out of range");
+		else if( (i > 1) && config.output.packed_fec )
+			size = CONFIG_FAIL("iss", uuid, path, "batching needs FEC disabled");
+		else
+		{
+			config.output.batch.frames = i ? i : 1;
+			output_batch_reset(0);
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_batch_latency(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1) // query
+	{
+		float f = config.output.batch.latency;
+		size = CONFIG_SUCCESS("isf", uuid, path, f);
+	}
+	else
+	{
+		float f;
+		buf_ptr = osc_get_float(buf_ptr, &f);
+		if( (f >= 0.f) && (f <= 1.f) ) // NaN fails both
+		{
+			config.output.batch.latency = f;
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "latency out of range");
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_fingering_float(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, float *val)
+{
+	uint_fast8_t res = config_check_float(path, fmt, argc, buf, val);
+
+	if(argc > 1)
+		fingering_configure(&config.output.fingering);
+
+	return res;
+}
+
+static uint_fast8_t
+_fingering_threshold(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _fingering_float(path, fmt, argc, buf, &config.output.fingering.threshold);
+}
+
+static uint_fast8_t
+_fingering_settle(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _fingering_float(path, fmt, argc, buf, &config.output.fingering.settle);
+}
+
+static uint_fast8_t
+_fingering_size(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.output.fingering.size);
+
+	if(argc > 1)
+	{
+		if(config.output.fingering.size > FINGERING_MAX)
+			config.output.fingering.size = FINGERING_MAX;
+		fingering_configure(&config.output.fingering);
+	}
+
+	return res;
+}
+
+static uint_fast8_t
+_fingering_entry(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+	int32_t i;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+	buf_ptr = osc_get_int32(buf_ptr, &i);
+
+	if( (i < 0) || (i >= FINGERING_MAX) )
+		size = CONFIG_FAIL("iss", uuid, path, "entry out of range");
+	else if(argc == 2) // query
+	{
+		Fingering_Entry *entry = &config.output.fingering.table[i];
+		size = CONFIG_SUCCESS("isiiii", uuid, path, i, entry->mask, entry->care, entry->note);
+	}
+	else
+	{
+		Fingering_Entry *entry = &config.output.fingering.table[i];
+		int32_t mask, care, note;
+		buf_ptr = osc_get_int32(buf_ptr, &mask);
+		buf_ptr = osc_get_int32(buf_ptr, &care);
+		buf_ptr = osc_get_int32(buf_ptr, &note);
+		if( (mask < 0) || (mask > 0xff) || (care < 0) || (care > 0xff) )
+			size = CONFIG_FAIL("iss", uuid, path, "mask out of range");
+		else if( (note < 0) || (note > 0x7f) )
+			size = CONFIG_FAIL("iss", uuid, path, "note out of range");
+		else if(mask & ~care) // pressed valves must be cared for
+			size = CONFIG_FAIL("iss", uuid, path, "mask outside care");
+		else
+		{
+			entry->mask = mask;
+			entry->care = care;
+			entry->note = note;
+			fingering_configure(&config.output.fingering);
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_reset_soft(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+	int32_t sec;
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	// reset factory reset flag
+	bkp_enable_writes();
+	bkp_write(RESET_MODE_REG, RESET_MODE_FLASH_SOFT);
+	bkp_disable_writes();
+
+	nvic_sys_reset();
+
+	return 1;
+}
+
+static uint_fast8_t
+_reset_hard(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+	int32_t sec;
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	// set factory reset flag
+	bkp_enable_writes();
+	bkp_write(RESET_MODE_REG, RESET_MODE_FLASH_HARD);
+	bkp_disable_writes();
+
+	nvic_sys_reset();
+
+	return 1;
+}
+
+static uint_fast8_t
+_reset_flash(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+	int32_t sec;
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	// set bootloader flag
+	bkp_enable_writes();
+	bkp_write(RESET_MODE_REG, RESET_MODE_SYSTEM_FLASH);
+	bkp_disable_writes();
+
+	nvic_sys_reset();
+
+	return 1;
+}
+
+static uint_fast8_t _query(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf);
+
+// globals
+const OSC_Method config_serv [] = {
+	{NULL, NULL, _query},
+	{NULL, NULL, NULL} // terminator
+};
+
+const OSC_Query_Value config_mode_args_values [] = {
+	[OSC_MODE_UDP]	= { .s = "osc.udp" },
+	[OSC_MODE_TCP]	= { .s = "osc.tcp" },
+	[OSC_MODE_SLIP]	= { .s = "osc.slip.tcp" }
+};
+
+const OSC_Query_Argument config_mode_args [] = {
+	OSC_QUERY_ARGUMENT_STRING_VALUES("mode", OSC_QUERY_MODE_RW, config_mode_args_values)
+};
+
+// global arguments
+const OSC_Query_Argument config_boolean_args [] = {
+	OSC_QUERY_ARGUMENT_BOOL("Boolean", OSC_QUERY_MODE_RW)
+};
+
+const OSC_Query_Argument config_address_args [] = {
+	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted or mDNS .local domain with colon and port", OSC_QUERY_MODE_RW, 64)
+};
+
+// locals
+static const OSC_Query_Argument comm_mac_args [] = {
+	OSC_QUERY_ARGUMENT_STRING("EUI-48 hexadecimal colon", OSC_QUERY_MODE_RW, 17)
+};
+
+static const OSC_Query_Argument comm_ip_args [] = {
+	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted CIDR", OSC_QUERY_MODE_RW, 18)
+};
+
+static const OSC_Query_Argument comm_gateway_args [] = {
+	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted or mDNS .local domain", OSC_QUERY_MODE_RW, 64)
+};
+
+static const OSC_Query_Argument comm_address_args [] = {
+	OSC_QUERY_ARGUMENT_STRING("32-bit decimal dotted or mDNS .local domain", OSC_QUERY_MODE_W, 64)
+};
+
+static const OSC_Query_Argument comm_sockets_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Socket", OSC_QUERY_MODE_W, 0, WIZ_MAX_SOCK_NUM - 1, 1),
+	OSC_QUERY_ARGUMENT_INT32("TX KB", OSC_QUERY_MODE_R, 0, 16, 1),
+	OSC_QUERY_ARGUMENT_INT32("RX KB", OSC_QUERY_MODE_R, 0, 16, 1)
+};
+
+static const OSC_Query_Argument spi_divider_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Of peripheral clock", OSC_QUERY_MODE_R, 2, 256, 2)
+};
+
+static const OSC_Query_Argument spi_traffic_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Transactions", OSC_QUERY_MODE_R, INT32_MIN, INT32_MAX, 1),
+	OSC_QUERY_ARGUMENT_INT32("Bytes", OSC_QUERY_MODE_R, INT32_MIN, INT32_MAX, 1),
+	OSC_QUERY_ARGUMENT_INT32("Busy us", OSC_QUERY_MODE_R, INT32_MIN, INT32_MAX, 1)
+};
+
+static const OSC_Query_Argument spi_errors_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("DMA errors", OSC_QUERY_MODE_R, 0, INT32_MAX, 1),
+	OSC_QUERY_ARGUMENT_INT32("Overruns", OSC_QUERY_MODE_R, 0, INT32_MAX, 1),
+	OSC_QUERY_ARGUMENT_INT32("Mode faults", OSC_QUERY_MODE_R, 0, INT32_MAX, 1),
+	OSC_QUERY_ARGUMENT_INT32("Dropped jobs", OSC_QUERY_MODE_R, 0, INT32_MAX, 1)
+};
+
+static const OSC_Query_Item spi_tree [] = {
+	OSC_QUERY_ITEM_METHOD("adaptive", "Step clock down on error bursts", _spi_adaptive, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("divider", "Current clock divider", _spi_divider, spi_divider_args),
+	OSC_QUERY_ITEM_METHOD("traffic", "Transactions, bytes and bus time", _spi_traffic, spi_traffic_args),
+	OSC_QUERY_ITEM_METHOD("errors", "Transfer errors by type", _spi_errors, spi_errors_args),
+	OSC_QUERY_ITEM_METHOD("reset", "Reset statistics", _spi_reset, NULL)
+};
+
+const OSC_Query_Item comm_tree [] = {
+	OSC_QUERY_ITEM_METHOD("mac", "Hardware MAC address", _comm_mac, comm_mac_args),
+	OSC_QUERY_ITEM_METHOD("ip", "IPv4 client address", _comm_ip, comm_ip_args),
+	OSC_QUERY_ITEM_METHOD("gateway", "IPv4 gateway address", _comm_gateway, comm_gateway_args),
+	OSC_QUERY_ITEM_METHOD("address", "Shared remote IPv4 address", _comm_address, comm_address_args),
+	OSC_QUERY_ITEM_METHOD("sockets", "Socket buffer split", _comm_sockets, comm_sockets_args),
+	OSC_QUERY_ITEM_NODE("spi/", "WIZnet SPI link", spi_tree)
+};
+
+const OSC_Query_Item config_tree [] = {
+	OSC_QUERY_ITEM_METHOD("save", "Save to EEPROM", _config_save, NULL),
+	OSC_QUERY_ITEM_METHOD("load", "Load from EEPROM", _config_load, NULL),
+	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable socket", _config_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("address", "Single remote IPv4 address", _config_address, config_address_args),
+	OSC_QUERY_ITEM_METHOD("mode", "Enable/disable UDP/TCP mode", _config_mode, config_mode_args)
+};
+
+const OSC_Query_Item reset_tree [] = {
+	OSC_QUERY_ITEM_METHOD("soft", "Soft reset", _reset_soft, NULL),
+	OSC_QUERY_ITEM_METHOD("hard", "Hard reset", _reset_hard, NULL),
+	OSC_QUERY_ITEM_METHOD("flash", "Reset into flash mode", _reset_flash, NULL),
+};
+
+static const OSC_Query_Argument info_version_args [] = {
+	OSC_QUERY_ARGUMENT_STRING("{Major}.{Minor}.{Patch level}-{Board revision}", OSC_QUERY_MODE_R, 32)
+};
 
 static const OSC_Query_Argument info_uid_args [] = {
 	OSC_QUERY_ARGUMENT_STRING("Hexadecimal hyphen", OSC_QUERY_MODE_R, 32)
@@ -1085,6 +1608,274 @@ static const OSC_Query_Item info_tree [] = {
 	OSC_QUERY_ITEM_METHOD("name", "Device name", _info_name, info_name_args),
 };
 
+static uint_fast8_t
+_sensors_rate(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isi", uuid, path, config.sensors.rate);
+	else
+	{
+		int32_t i;
+		buf_ptr = osc_get_int32(buf_ptr, &i);
+		if( (i == 0) || ( (i >= SENSORS_RATE_MIN) && (i <= SENSORS_RATE_MAX) ) )
+		{
+			config.sensors.rate = i;
+			if(config.sensors.rate)
+				adc_timer_reconfigure();
+			breath_configure(&config.sensors.breath, config.sensors.rate);
+			autozero_configure(&config.sensors.autozero, config.sensors.rate);
+			fingering_configure(&config.output.fingering);
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "rate out of range");
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_sensors_divider(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_uint8(path, fmt, argc, buf, &config.sensors.valve_divider);
+
+	if(config.sensors.valve_divider == 0)
+		config.sensors.valve_divider = 1;
+
+	return res;
+}
+
+static uint_fast8_t
+_sensors_phase_lock(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.sensors.phase_lock);
+}
+
+static uint_fast8_t
+_breath_float(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, float *val)
+{
+	uint_fast8_t res = config_check_float(path, fmt, argc, buf, val);
+
+	if(argc > 1)
+		breath_configure(&config.sensors.breath, config.sensors.rate);
+
+	return res;
+}
+
+// setter only accepts values strictly between lo and hi
+static uint_fast8_t
+_breath_float_range(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf, float *val,
+	float lo, float hi)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	if(argc == 1) // query
+		size = CONFIG_SUCCESS("isf", uuid, path, *val);
+	else
+	{
+		float f;
+		buf_ptr = osc_get_float(buf_ptr, &f);
+		if( (f > lo) && (f < hi) )
+		{
+			*val = f;
+			breath_configure(&config.sensors.breath, config.sensors.rate);
+			size = CONFIG_SUCCESS("is", uuid, path);
+		}
+		else
+			size = CONFIG_FAIL("iss", uuid, path, "value out of range");
+	}
+
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_breath_attack(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _breath_float(path, fmt, argc, buf, &config.sensors.breath.attack);
+}
+
+static uint_fast8_t
+_breath_release(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _breath_float(path, fmt, argc, buf, &config.sensors.breath.release);
+}
+
+static uint_fast8_t
+_breath_adapt(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _breath_float(path, fmt, argc, buf, &config.sensors.breath.adapt);
+}
+
+static uint_fast8_t
+_breath_open(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	// gate needs hysteresis
+	return _breath_float_range(path, fmt, argc, buf, &config.sensors.breath.open,
+		config.sensors.breath.close, INFINITY);
+}
+
+static uint_fast8_t
+_breath_close(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return _breath_float_range(path, fmt, argc, buf, &config.sensors.breath.close,
+		-INFINITY, config.sensors.breath.open);
+}
+
+static uint_fast8_t
+_breath_curve(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	// log and exp shapes are undefined for a flat curve
+	return _breath_float_range(path, fmt, argc, buf, &config.sensors.breath.curve,
+		0.f, INFINITY);
+}
+
+static const OSC_Query_Value breath_shape_args_values [] = {
+	[BREATH_SHAPE_LIN]	= { .s = "lin" },
+	[BREATH_SHAPE_LOG]	= { .s = "log" },
+	[BREATH_SHAPE_EXP]	= { .s = "exp" }
+};
+
+static uint_fast8_t
+_breath_shape(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = _config_string_value(path, fmt, argc, buf, breath_shape_args_values,
+		sizeof(breath_shape_args_values)/sizeof(OSC_Query_Value), &config.sensors.breath.shape);
+
+	if(argc > 1)
+		breath_configure(&config.sensors.breath, config.sensors.rate);
+
+	return res;
+}
+
+static const OSC_Query_Argument breath_time_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Seconds", OSC_QUERY_MODE_RW, 0.f, 10.f, 0.0001f)
+};
+
+static const OSC_Query_Argument breath_threshold_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Above noise floor", OSC_QUERY_MODE_RW, 0.f, 1.f, 0.001f)
+};
+
+static const OSC_Query_Argument breath_curve_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Curvature", OSC_QUERY_MODE_RW, 0.1f, 20.f, 0.1f)
+};
+
+static const OSC_Query_Argument breath_shape_args [] = {
+	OSC_QUERY_ARGUMENT_STRING_VALUES("Response", OSC_QUERY_MODE_RW, breath_shape_args_values)
+};
+
+static const OSC_Query_Item breath_tree [] = {
+	OSC_QUERY_ITEM_METHOD("attack", "Envelope attack time", _breath_attack, breath_time_args),
+	OSC_QUERY_ITEM_METHOD("release", "Envelope release time", _breath_release, breath_time_args),
+	OSC_QUERY_ITEM_METHOD("adapt", "Noise floor adaption time", _breath_adapt, breath_time_args),
+	OSC_QUERY_ITEM_METHOD("open", "Gate open threshold", _breath_open, breath_threshold_args),
+	OSC_QUERY_ITEM_METHOD("close", "Gate close threshold", _breath_close, breath_threshold_args),
+	OSC_QUERY_ITEM_METHOD("curve", "Response curvature", _breath_curve, breath_curve_args),
+	OSC_QUERY_ITEM_METHOD("shape", "Response shape", _breath_shape, breath_shape_args)
+};
+
+static uint_fast8_t
+_autozero_enabled(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_bool(path, fmt, argc, buf, &config.sensors.autozero.enabled);
+}
+
+static uint_fast8_t
+_autozero_time(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	uint_fast8_t res = config_check_float(path, fmt, argc, buf, &config.sensors.autozero.time);
+
+	if(argc > 1)
+		autozero_configure(&config.sensors.autozero, config.sensors.rate);
+
+	return res;
+}
+
+static uint_fast8_t
+_autozero_bound(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	return config_check_float(path, fmt, argc, buf, &config.sensors.autozero.bound);
+}
+
+static uint_fast8_t
+_autozero_commit(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	autozero_commit();
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static uint_fast8_t
+_autozero_reset(const char *path, const char *fmt, uint_fast8_t argc, osc_data_t *buf)
+{
+	osc_data_t *buf_ptr = buf;
+	uint16_t size;
+	int32_t uuid;
+
+	buf_ptr = osc_get_int32(buf_ptr, &uuid);
+
+	autozero_reset();
+
+	size = CONFIG_SUCCESS("is", uuid, path);
+	CONFIG_SEND(size);
+
+	return 1;
+}
+
+static const OSC_Query_Argument autozero_time_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Seconds", OSC_QUERY_MODE_RW, 1.f, 3600.f, 1.f)
+};
+
+static const OSC_Query_Argument autozero_bound_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("ADC LSB", OSC_QUERY_MODE_RW, 0.f, 512.f, 1.f)
+};
+
+static const OSC_Query_Item autozero_tree [] = {
+	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable drift tracking", _autozero_enabled, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("time", "Tracking time constant", _autozero_time, autozero_time_args),
+	OSC_QUERY_ITEM_METHOD("bound", "Maximal offset from calibrated quiescent", _autozero_bound, autozero_bound_args),
+	OSC_QUERY_ITEM_METHOD("commit", "Fold offsets into calibration, save with /calibration/save", _autozero_commit, NULL),
+	OSC_QUERY_ITEM_METHOD("reset", "Discard offsets", _autozero_reset, NULL)
+};
+
+static const OSC_Query_Argument sensors_rate_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Hz, 0 runs unthrottled", OSC_QUERY_MODE_RW, 0, SENSORS_RATE_MAX, 1)
+};
+
+static const OSC_Query_Argument sensors_divider_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Frames per valve update", OSC_QUERY_MODE_RW, 1, 255, 1)
+};
+
+static const OSC_Query_Item sensors_tree [] = {
+	OSC_QUERY_ITEM_METHOD("rate", "Frame and breath sensor rate", _sensors_rate, sensors_rate_args),
+	OSC_QUERY_ITEM_METHOD("divider", "Valve rate divider", _sensors_divider, sensors_divider_args),
+	OSC_QUERY_ITEM_METHOD("phase_lock", "Lock sampling to PTP time", _sensors_phase_lock, config_boolean_args),
+	OSC_QUERY_ITEM_NODE("breath/", "Breath envelope and gate", breath_tree),
+	OSC_QUERY_ITEM_NODE("autozero/", "Quiescent drift tracking", autozero_tree)
+};
+
 static const OSC_Query_Argument engines_offset_args [] = {
 	OSC_QUERY_ARGUMENT_FLOAT("Seconds", OSC_QUERY_MODE_RW, 0.f, INFINITY, 0.0001f)
 };
@@ -1094,15 +1885,98 @@ static const OSC_Query_Argument engines_invert_args [] = {
 	OSC_QUERY_ARGUMENT_BOOL("z-axis inversion", OSC_QUERY_MODE_RW)
 };
 
+static const OSC_Query_Argument engines_engine_args [] = {
+	OSC_QUERY_ARGUMENT_STRING_VALUES("Serializer", OSC_QUERY_MODE_RW, engines_engine_args_values)
+};
+
+static const OSC_Query_Argument midi_mode_args [] = {
+	OSC_QUERY_ARGUMENT_STRING_VALUES("Mapping", OSC_QUERY_MODE_RW, midi_mode_args_values)
+};
+
+static const OSC_Query_Argument midi_channel_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Channel", OSC_QUERY_MODE_RW, 0, 15, 1)
+};
+
+static const OSC_Query_Argument midi_cc_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Sensor", OSC_QUERY_MODE_W, 0, SENSOR_N - 1, 1),
+	OSC_QUERY_ARGUMENT_INT32("Controller MSB", OSC_QUERY_MODE_RW, 0, 31, 1)
+};
+
+static const OSC_Query_Argument midi_note_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Sensor", OSC_QUERY_MODE_W, 0, SENSOR_N - 2, 1),
+	OSC_QUERY_ARGUMENT_INT32("Note", OSC_QUERY_MODE_RW, 0, 127, 1)
+};
+
+static const OSC_Query_Item midi_tree [] = {
+	OSC_QUERY_ITEM_METHOD("mode", "14-bit CC or MPE", _midi_mode, midi_mode_args),
+	OSC_QUERY_ITEM_METHOD("channel", "CC channel or MPE manager channel", _midi_channel, midi_channel_args),
+	OSC_QUERY_ITEM_METHOD("cc", "Sensor to controller map", _midi_cc, midi_cc_args),
+	OSC_QUERY_ITEM_METHOD("note", "Valve to note map (MPE)", _midi_note, midi_note_args)
+};
+
+static const OSC_Query_Argument packed_fec_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Group size", OSC_QUERY_MODE_RW, 0, PACKED_FEC_MAX, 1)
+};
+
+static const OSC_Query_Item packed_tree [] = {
+	OSC_QUERY_ITEM_METHOD("q15", "Q15 normalized instead of raw values", _packed_q15, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("fec", "XOR parity every n frames, 0 to disable", _packed_fec, packed_fec_args)
+};
+
+static const OSC_Query_Argument batch_frames_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Frames", OSC_QUERY_MODE_RW, 1, 64, 1)
+};
+
+static const OSC_Query_Argument batch_latency_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Seconds", OSC_QUERY_MODE_RW, 0.f, 0.1f, 0.0001f)
+};
+
+static const OSC_Query_Item batch_tree [] = {
+	OSC_QUERY_ITEM_METHOD("frames", "Frames per datagram (UDP only)", _batch_frames, batch_frames_args),
+	OSC_QUERY_ITEM_METHOD("latency", "Latency ceiling", _batch_latency, batch_latency_args)
+};
+
+static const OSC_Query_Argument fingering_threshold_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Valve value", OSC_QUERY_MODE_RW, 0.f, 1.f, 0.001f)
+};
+
+static const OSC_Query_Argument fingering_settle_args [] = {
+	OSC_QUERY_ARGUMENT_FLOAT("Seconds", OSC_QUERY_MODE_RW, 0.f, 0.1f, 0.0001f)
+};
+
+static const OSC_Query_Argument fingering_size_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Entries", OSC_QUERY_MODE_RW, 0, FINGERING_MAX, 1)
+};
+
+static const OSC_Query_Argument fingering_entry_args [] = {
+	OSC_QUERY_ARGUMENT_INT32("Entry", OSC_QUERY_MODE_W, 0, FINGERING_MAX - 1, 1),
+	OSC_QUERY_ARGUMENT_INT32("Closed valves", OSC_QUERY_MODE_RW, 0, 0xff, 1),
+	OSC_QUERY_ARGUMENT_INT32("Valves cared for", OSC_QUERY_MODE_RW, 0, 0xff, 1),
+	OSC_QUERY_ARGUMENT_INT32("Note", OSC_QUERY_MODE_RW, 0, 127, 1)
+};
+
+static const OSC_Query_Item fingering_tree [] = {
+	OSC_QUERY_ITEM_METHOD("threshold", "Valve closed threshold", _fingering_threshold, fingering_threshold_args),
+	OSC_QUERY_ITEM_METHOD("settle", "Chord settle window", _fingering_settle, fingering_settle_args),
+	OSC_QUERY_ITEM_METHOD("size", "Used table entries", _fingering_size, fingering_size_args),
+	OSC_QUERY_ITEM_METHOD("entry", "Fingering table entry", _fingering_entry, fingering_entry_args)
+};
+
 static const OSC_Query_Item engines_tree [] = {
 	OSC_QUERY_ITEM_METHOD("enabled", "Enable/disable", _output_enabled, config_boolean_args),
 	OSC_QUERY_ITEM_METHOD("address", "Single remote host", _output_address, config_address_args),
 	OSC_QUERY_ITEM_METHOD("offset", "OSC bundle offset timestamp", _output_offset, engines_offset_args),
 	OSC_QUERY_ITEM_METHOD("invert", "Enable/disable axis inversion", _output_invert, engines_invert_args),
 	OSC_QUERY_ITEM_METHOD("parallel", "Parallel processing", _output_parallel, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("queue", "Queue frames in socket TX memory (UDP only)", _output_queue, config_boolean_args),
 	OSC_QUERY_ITEM_METHOD("reset", "Disable all engines", _output_reset, NULL),
 	OSC_QUERY_ITEM_METHOD("mode", "Enable/disable UDP/TCP mode", _output_mode, config_mode_args),
-	OSC_QUERY_ITEM_METHOD("server", "Enable/disable TCP server mode", _output_server, config_boolean_args)
+	OSC_QUERY_ITEM_METHOD("server", "Enable/disable TCP server mode", _output_server, config_boolean_args),
+	OSC_QUERY_ITEM_METHOD("engine", "Active output serializer", _output_engine, engines_engine_args),
+	OSC_QUERY_ITEM_NODE("midi/", "MIDI output engine", midi_tree),
+	OSC_QUERY_ITEM_NODE("packed/", "Packed binary output engine", packed_tree),
+	OSC_QUERY_ITEM_NODE("batch/", "Multi-frame datagrams", batch_tree),
+	OSC_QUERY_ITEM_NODE("fingering/", "Fingering to note engine", fingering_tree)
 };
 
 static const OSC_Query_Item root_tree [] = {
@@ -1120,8 +1994,10 @@ static const OSC_Query_Item root_tree [] = {
 	OSC_QUERY_ITEM_NODE("mdns/", "Multicast DNS", mdns_tree),
 
 	// output engines
+	OSC_QUERY_ITEM_NODE("sensors/", "Sensor acquisition", sensors_tree),
 	OSC_QUERY_ITEM_NODE("engines/", "Output engines", engines_tree),
-	OSC_QUERY_ITEM_NODE("calibration/", "Calibration", calibration_tree)
+	OSC_QUERY_ITEM_NODE("calibration/", "Calibration", calibration_tree),
+	OSC_QUERY_ITEM_NODE("capture/", "Raw sensor capture", capture_tree)
 };
 
 static const OSC_Query_Item root = OSC_QUERY_ITEM_NODE("/", "Root node", root_tree);
@@ -0,0 +1,724 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#include <string.h>
+
+#include <engines.h>
+#include <netdef.h>
+
+/*
+ * hardware independent output serializers, shared by the firmware and the host tools
+ */
+
+osc_data_t *
+engines_dump_raw(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	osc_data_t *bndl;
+	osc_data_t *itm;
+	osc_data_t *buf_ptr = buf;
+	
+	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+			buf_ptr = osc_set_path(buf_ptr, "/dmp");
+			buf_ptr = osc_set_fmt(buf_ptr, "ifffffffff");
+			buf_ptr = osc_set_int32(buf_ptr, frm);
+			for(i=0; i<SENSOR_N; i++)
+				//buf_ptr = osc_set_float(buf_ptr, adc_filt[i].OO1);
+				buf_ptr = osc_set_float(buf_ptr, adc_raw[i]);
+		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+
+	return buf_ptr;
+}
+
+osc_data_t *
+engines_dump_val(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	osc_data_t *bndl;
+	osc_data_t *itm;
+	osc_data_t *buf_ptr = buf;
+	
+	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+			buf_ptr = osc_set_path(buf_ptr, "/val");
+			buf_ptr = osc_set_fmt(buf_ptr, "itfffffffff");
+			buf_ptr = osc_set_int32(buf_ptr, frm);
+			buf_ptr = osc_set_timetag(buf_ptr, now);
+			for(i=0; i<SENSOR_N; i++)
+				buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
+		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+
+	return buf_ptr;
+}
+
+osc_data_t *
+engines_lossless(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	osc_data_t *bndl;
+	osc_data_t *itm;
+	osc_data_t *buf_ptr = buf;
+	char fmt[SENSOR_N+1];
+	char *fmt_ptr = fmt;
+	
+	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+			buf_ptr = osc_set_path(buf_ptr, "/frm");
+			buf_ptr = osc_set_fmt(buf_ptr, "it");
+			buf_ptr = osc_set_int32(buf_ptr, frm);
+			buf_ptr = osc_set_timetag(buf_ptr, now);
+		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+
+		for(i=0; i<SENSOR_N; i++)
+		{
+			if(!sensors_is_fresh(i)) // decimated group, keep alive without a new value
+			{
+				if( (adc_state[i] == ADC_STATE_ON) || (adc_state[i] == ADC_STATE_SET) )
+					*fmt_ptr++ = 'i';
+				continue;
+			}
+
+			switch(adc_state[i])
+			{
+				case ADC_STATE_IDLE:
+				case ADC_STATE_OFF:
+					break;
+				case ADC_STATE_ON:
+				case ADC_STATE_SET:
+					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+						buf_ptr = osc_set_path(buf_ptr, "/tok");
+						buf_ptr = osc_set_fmt(buf_ptr, "if");
+						buf_ptr = osc_set_int32(buf_ptr, i);
+						buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
+					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+					*fmt_ptr++ = 'i';
+					break;
+			}
+		}
+		*fmt_ptr = '\0';
+
+		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+			buf_ptr = osc_set_path(buf_ptr, "/alv");
+			buf_ptr = osc_set_fmt(buf_ptr, fmt);
+			for(i=0; i<SENSOR_N; i++)
+				switch(adc_state[i])
+				{
+					case ADC_STATE_IDLE:
+					case ADC_STATE_OFF:
+						break;
+					case ADC_STATE_ON:
+					case ADC_STATE_SET:
+						buf_ptr = osc_set_int32(buf_ptr, i);
+						break;
+				}
+		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+
+	return buf_ptr;
+}
+
+osc_data_t *
+engines_lossy(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	osc_data_t *bndl;
+	osc_data_t *itm;
+	osc_data_t *buf_ptr = buf;
+	
+	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		for(i=0; i<SENSOR_N; i++)
+		{
+			if(!sensors_is_fresh(i)) // decimated group
+				continue;
+
+			switch(adc_state[i])
+			{
+				case ADC_STATE_IDLE:
+					break;
+				case ADC_STATE_OFF:
+					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+						buf_ptr = osc_set_path(buf_ptr, "/off");
+						buf_ptr = osc_set_fmt(buf_ptr, "i");
+						buf_ptr = osc_set_int32(buf_ptr, i);
+					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+					break;
+				case ADC_STATE_ON:
+					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+						buf_ptr = osc_set_path(buf_ptr, "/on");
+						buf_ptr = osc_set_fmt(buf_ptr, "if");
+						buf_ptr = osc_set_int32(buf_ptr, i);
+						buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
+					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+					break;
+				case ADC_STATE_SET:
+					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+						buf_ptr = osc_set_path(buf_ptr, "/set");
+						buf_ptr = osc_set_fmt(buf_ptr, "if");
+						buf_ptr = osc_set_int32(buf_ptr, i);
+						buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
+					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+					break;
+			}
+		}
+	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+
+	return buf_ptr;
+}
+
+/*
+ * MIDI output via OSC 'm' arguments, all events of a frame in a single message
+ */
+
+#define MIDI_NOTE_OFF					0x80
+#define MIDI_NOTE_ON					0x90
+#define MIDI_CONTROLLER				0xb0
+#define MIDI_CHANNEL_PRESSURE	0xd0
+#define MIDI_PITCH_BEND				0xe0
+#define MIDI_EVENT_MAX				(3*SENSOR_N)
+
+static MIDI_Config midi;
+static uint16_t midi_last [SENSOR_N]; // last sent 14-bit value, 0xffff := none
+static uint8_t midi_events [MIDI_EVENT_MAX][4];
+static uint_fast8_t midi_n;
+static const MIDI_Config *midi_next; // applied once the sounding notes are released
+
+static void
+_midi_apply(const MIDI_Config *cfg)
+{
+	uint_fast8_t i;
+
+	midi = *cfg;
+	midi.channel &= 0xf;
+	for(i=0; i<SENSOR_N; i++)
+	{
+		midi.cc[i] &= 0x1f;
+		midi.note[i] &= 0x7f;
+		midi_last[i] = 0xffff;
+	}
+}
+
+// MPE valves keep their last value while their note sounds
+static uint_fast8_t
+_midi_sounding()
+{
+	uint_fast8_t i;
+
+	if(midi.mode != MIDI_MODE_MPE)
+		return 0;
+
+	for(i=0; i<SENSOR_BREATH; i++)
+		if(midi_last[i] != 0xffff)
+			return 1;
+
+	return 0;
+}
+
+// sounding notes need their note-off with the old mapping, defer to the next frame
+void
+midi_configure(const MIDI_Config *cfg)
+{
+	if(_midi_sounding())
+		midi_next = cfg;
+	else
+	{
+		midi_next = NULL;
+		_midi_apply(cfg);
+	}
+}
+
+static inline __always_inline uint16_t
+_midi_14bit(float val)
+{
+	if(val <= 0.f)
+		return 0;
+	if(val >= 1.f)
+		return 0x3fff;
+	return val * 0x3fff;
+}
+
+static inline __always_inline void
+_midi_push(uint8_t status, uint8_t d1, uint8_t d2)
+{
+	uint8_t *m = midi_events[midi_n++];
+
+	m[0] = 0; // port
+	m[1] = status;
+	m[2] = d1;
+	m[3] = d2;
+}
+
+static inline __always_inline void
+_midi_bend(uint8_t ch, uint16_t v)
+{
+	const uint16_t b = 0x2000 + (v >> 1); // released valve sits at center
+
+	_midi_push(MIDI_PITCH_BEND | ch, b & 0x7f, b >> 7);
+}
+
+static inline __always_inline uint8_t
+_midi_member(uint_fast8_t i)
+{
+	return (midi.channel + 1 + i) & 0xf;
+}
+
+static void
+_midi_cc(uint_fast8_t i)
+{
+	uint16_t v;
+
+	switch(adc_state[i])
+	{
+		case ADC_STATE_IDLE:
+			return;
+		case ADC_STATE_OFF:
+			v = 0;
+			break;
+		case ADC_STATE_ON:
+		case ADC_STATE_SET:
+		default:
+			v = _midi_14bit(adc_val1[i]);
+			break;
+	}
+
+	if(v == midi_last[i])
+		return;
+
+	if( (v >> 7) != (midi_last[i] >> 7) ) // MSB resets LSB on the receiver, only resend it on change
+		_midi_push(MIDI_CONTROLLER | midi.channel, midi.cc[i], v >> 7);
+	_midi_push(MIDI_CONTROLLER | midi.channel, midi.cc[i] + 0x20, v & 0x7f);
+	midi_last[i] = v;
+}
+
+static void
+_midi_mpe_valve(uint_fast8_t i)
+{
+	const uint8_t ch = _midi_member(i);
+	uint16_t v;
+
+	switch(adc_state[i])
+	{
+		case ADC_STATE_IDLE:
+			break;
+		case ADC_STATE_OFF:
+			_midi_push(MIDI_NOTE_OFF | ch, midi.note[i], 0);
+			midi_last[i] = 0xffff;
+			break;
+		case ADC_STATE_ON:
+			v = _midi_14bit(adc_val1[i]);
+			_midi_bend(ch, v); // bend precedes note on
+			_midi_push(MIDI_NOTE_ON | ch, midi.note[i], (v >> 7) ? v >> 7 : 1);
+			midi_last[i] = v;
+			break;
+		case ADC_STATE_SET:
+			if(midi_last[i] == 0xffff) // released by a reconfiguration, wait for the next note on
+				break;
+			v = _midi_14bit(adc_val1[i]);
+			if(v != midi_last[i])
+			{
+				_midi_bend(ch, v);
+				midi_last[i] = v;
+			}
+			break;
+	}
+}
+
+static void
+_midi_release_push()
+{
+	uint_fast8_t i;
+
+	if(_midi_sounding())
+		for(i=0; i<SENSOR_BREATH; i++)
+			if(midi_last[i] != 0xffff)
+			{
+				_midi_push(MIDI_NOTE_OFF | _midi_member(i), midi.note[i], 0);
+				midi_last[i] = 0xffff;
+			}
+
+	if(midi_next)
+	{
+		_midi_apply(midi_next);
+		midi_next = NULL;
+	}
+}
+
+static void
+_midi_mpe_breath(void)
+{
+	const uint_fast8_t b = SENSOR_BREATH;
+	uint_fast8_t i;
+	uint8_t p;
+
+	if(adc_state[b] == ADC_STATE_IDLE)
+		return;
+
+	p = (adc_state[b] == ADC_STATE_OFF) ? 0 : _midi_14bit(adc_val1[b]) >> 7;
+	if(p == midi_last[b])
+		return;
+
+	for(i=0; i<SENSOR_BREATH; i++) // pressure on every sounding note
+		if( (adc_state[i] == ADC_STATE_ON) || (adc_state[i] == ADC_STATE_SET) )
+			_midi_push(MIDI_CHANNEL_PRESSURE | _midi_member(i), p, 0);
+	midi_last[b] = p;
+}
+
+static osc_data_t *
+_midi_bundle(osc_data_t *buf, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	osc_data_t *bndl;
+	osc_data_t *itm;
+	osc_data_t *buf_ptr = buf;
+	char fmt[MIDI_EVENT_MAX+1];
+
+	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		if(midi_n)
+		{
+			memset(fmt, 'm', midi_n);
+			fmt[midi_n] = '\0';
+
+			buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+				buf_ptr = osc_set_path(buf_ptr, "/midi");
+				buf_ptr = osc_set_fmt(buf_ptr, fmt);
+				for(i=0; i<midi_n; i++)
+					buf_ptr = osc_set_midi(buf_ptr, midi_events[i]);
+			buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+		}
+	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+
+	return buf_ptr;
+}
+
+osc_data_t *
+midi_release(osc_data_t *buf, OSC_Timetag offset)
+{
+	midi_n = 0;
+	_midi_release_push();
+
+	return _midi_bundle(buf, offset);
+}
+
+osc_data_t *
+engines_midi(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+
+	midi_n = 0;
+	if(midi_next) // configuration changed while notes sounded
+		_midi_release_push();
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		if(!sensors_is_fresh(i)) // decimated group
+			continue;
+
+		if(midi.mode == MIDI_MODE_CC)
+			_midi_cc(i);
+		else if(i == SENSOR_BREATH)
+			_midi_mpe_breath();
+		else
+			_midi_mpe_valve(i);
+	}
+
+	return _midi_bundle(buf, offset);
+}
+
+/*
+ * packed binary frame, see engines.h for the layout
+ */
+
+static uint8_t packed_flags = 0;
+static uint8_t packed_fec = 0; // group size
+static uint8_t packed_fec_n = 0; // frames XORed into the current group
+static uint_fast8_t packed_fec_pending = 0; // parity of previous group not yet sent
+static int32_t packed_fec_first;
+static uint32_t packed_fec_acc [(PACKED_SIZE + 3) / 4];
+static uint32_t packed_fec_parity [(PACKED_SIZE + 3) / 4];
+
+void
+packed_configure(uint8_t q15, uint8_t fec)
+{
+	packed_flags = q15 ? PACKED_FLAG_Q15 : 0;
+	packed_fec = fec > PACKED_FEC_MAX ? PACKED_FEC_MAX : fec;
+	packed_fec_n = 0;
+	packed_fec_pending = 0;
+	packed_fec_first = -1; // wait for the next group boundary
+}
+
+static inline __always_inline int16_t
+_packed_q15(float val)
+{
+	if(val <= -1.f)
+		return -0x7fff;
+	if(val >= 1.f)
+		return 0x7fff;
+	return val * 0x7fff;
+}
+
+static void
+_packed_fec(const uint8_t *pkd, int32_t frm)
+{
+	const uint32_t *src = (const uint32_t *)pkd;
+	uint_fast8_t i;
+
+	if(frm % packed_fec == 0) // group boundary
+	{
+		packed_fec_first = frm;
+		packed_fec_n = 0;
+		memset(packed_fec_acc, 0, sizeof(packed_fec_acc));
+	}
+	else if( (packed_fec_first < 0) || (frm != packed_fec_first + packed_fec_n) ) // incomplete group
+	{
+		packed_fec_first = -1;
+		return;
+	}
+
+	for(i=0; i<sizeof(packed_fec_acc)/sizeof(uint32_t); i++)
+		packed_fec_acc[i] ^= src[i];
+
+	if(++packed_fec_n == packed_fec)
+	{
+		memcpy(packed_fec_parity, packed_fec_acc, sizeof(packed_fec_parity));
+		packed_fec_pending = 1;
+	}
+}
+
+osc_data_t *
+engines_packed(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	uint32_t states = 0;
+	osc_data_t *buf_ptr = buf;
+	osc_data_t *bndl = NULL;
+	osc_data_t *itm = NULL;
+	uint8_t *pkd;
+	uint8_t *pkd_ptr;
+	const uint_fast8_t parity = packed_fec_pending;
+
+	if(parity)
+	{
+		buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+	}
+
+	buf_ptr = osc_set_path(buf_ptr, "/pkd");
+	buf_ptr = osc_set_fmt(buf_ptr, "b");
+	buf_ptr = osc_set_blob_inline(buf_ptr, PACKED_SIZE, (void **)&pkd);
+
+	pkd[0] = PACKED_VERSION;
+	pkd[1] = packed_flags;
+	pkd[2] = SENSOR_N;
+	pkd[3] = packed_fec;
+	pkd_ptr = osc_set_int32(pkd + 4, frm);
+	pkd_ptr = osc_set_timetag(pkd_ptr, now);
+
+	for(i=0; i<SENSOR_N; i++)
+		states |= (uint32_t)adc_state[i] << (i*2);
+	ref_htonl(pkd_ptr, states);
+	pkd_ptr += 4;
+
+	if(packed_flags & PACKED_FLAG_Q15)
+		for(i=0; i<SENSOR_N; i++, pkd_ptr+=2)
+			ref_hton(pkd_ptr, _packed_q15(adc_val1[i]));
+	else
+		for(i=0; i<SENSOR_N; i++, pkd_ptr+=2)
+			ref_hton(pkd_ptr, adc_raw[i]);
+
+	if(parity) // previous group, never in the same datagram as its own frames
+	{
+		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+			buf_ptr = osc_set_path(buf_ptr, "/fec");
+			buf_ptr = osc_set_fmt(buf_ptr, "iib");
+			buf_ptr = osc_set_int32(buf_ptr, packed_fec_first);
+			buf_ptr = osc_set_int32(buf_ptr, packed_fec);
+			buf_ptr = osc_set_blob(buf_ptr, PACKED_SIZE, packed_fec_parity);
+		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+		buf_ptr = osc_end_bundle(buf_ptr, bndl);
+		packed_fec_pending = 0;
+	}
+
+	if(packed_fec)
+		_packed_fec(pkd, frm);
+
+	return buf_ptr;
+}
+
+/*
+ * fingering to note, see engines.h
+ */
+
+typedef struct _Fingering Fingering;
+
+struct _Fingering {
+	Fingering_Config cfg;
+	uint64_t settle; // 32.32 seconds
+	uint8_t candidate; // closed valves last frame
+	uint64_t t0; // 32.32 timetag the candidate first showed up
+	int16_t note; // sounding note, -1 := none
+};
+
+static Fingering fingering = {
+	.note = -1
+};
+
+// raw 32.32 bits, the same on host and device
+static inline __always_inline uint64_t
+_fingering_time(OSC_Timetag t)
+{
+	uint64_t raw;
+
+	memcpy(&raw, &t, sizeof(raw));
+
+	return raw;
+}
+
+// settle window is measured on the frame timetags, so it holds for unthrottled rates, too
+void
+fingering_configure(const Fingering_Config *cfg)
+{
+	fingering.cfg = *cfg;
+	if(fingering.cfg.size > FINGERING_MAX)
+		fingering.cfg.size = FINGERING_MAX;
+	fingering.settle = cfg->settle > 0.f ? cfg->settle * 0x1p32f : 0;
+}
+
+osc_data_t *
+fingering_release(osc_data_t *buf, OSC_Timetag offset)
+{
+	osc_data_t *bndl;
+	osc_data_t *itm;
+	osc_data_t *buf_ptr = buf;
+
+	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		if(fingering.note >= 0)
+		{
+			buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+				buf_ptr = osc_set_path(buf_ptr, "/note/off");
+				buf_ptr = osc_set_fmt(buf_ptr, "i");
+				buf_ptr = osc_set_int32(buf_ptr, fingering.note);
+			buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+			fingering.note = -1;
+		}
+	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+
+	return buf_ptr;
+}
+
+static inline __always_inline int16_t
+_fingering_lookup(uint8_t closed)
+{
+	uint_fast8_t i;
+
+	for(i=0; i<fingering.cfg.size; i++)
+	{
+		const Fingering_Entry *entry = &fingering.cfg.table[i];
+
+		if( (closed & entry->care) == entry->mask)
+			return entry->note & 0x7f;
+	}
+
+	return -1; // unknown fingering
+}
+
+osc_data_t *
+engines_fingering(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+{
+	uint_fast8_t i;
+	osc_data_t *bndl;
+	osc_data_t *itm;
+	osc_data_t *buf_ptr = buf;
+	const uint_fast8_t b = SENSOR_BREATH;
+	uint8_t closed = 0;
+	int16_t note;
+	uint_fast8_t settled;
+
+	for(i=0; i<SENSOR_BREATH; i++)
+		if( ( (adc_state[i] == ADC_STATE_ON) || (adc_state[i] == ADC_STATE_SET) )
+				&& (adc_val1[i] > fingering.cfg.threshold) )
+			closed |= 1 << i;
+
+	// a fingering only counts once it has been stable for the settle window
+	if(closed != fingering.candidate)
+	{
+		fingering.candidate = closed;
+		fingering.t0 = _fingering_time(now);
+	}
+	settled = _fingering_time(now) - fingering.t0 >= fingering.settle;
+
+	if( (adc_state[b] != ADC_STATE_ON) && (adc_state[b] != ADC_STATE_SET) )
+		note = -1; // breath gate closed, silence right away
+	else if(settled)
+		note = _fingering_lookup(closed);
+	else if(fingering.note >= 0) // in transition, hold
+		note = fingering.note;
+	else // onset during transition, wait for the fingering to settle
+		note = -1;
+
+	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
+		if(note != fingering.note)
+		{
+			if(fingering.note >= 0)
+			{
+				buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+					buf_ptr = osc_set_path(buf_ptr, "/note/off");
+					buf_ptr = osc_set_fmt(buf_ptr, "i");
+					buf_ptr = osc_set_int32(buf_ptr, fingering.note);
+				buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+			}
+			if(note >= 0)
+			{
+				buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+					buf_ptr = osc_set_path(buf_ptr, "/note/on");
+					buf_ptr = osc_set_fmt(buf_ptr, "if");
+					buf_ptr = osc_set_int32(buf_ptr, note);
+					buf_ptr = osc_set_float(buf_ptr, adc_val1[b]);
+				buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+			}
+			fingering.note = note;
+		}
+		else if( (note >= 0) && sensors_is_fresh(b) )
+		{
+			buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+				buf_ptr = osc_set_path(buf_ptr, "/note/exp");
+				buf_ptr = osc_set_fmt(buf_ptr, "f");
+				buf_ptr = osc_set_float(buf_ptr, adc_val1[b]);
+			buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+		}
+	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+
+	return buf_ptr;
+}
+
+const Engine_Frame_Cb engines_frame_cb [ENGINE_N] = {
+	[ENGINE_DUMP_RAW]	= engines_dump_raw,
+	[ENGINE_DUMP_VAL]	= engines_dump_val,
+	[ENGINE_LOSSLESS]	= engines_lossless,
+	[ENGINE_LOSSY]		= engines_lossy,
+	[ENGINE_MIDI]			= engines_midi,
+	[ENGINE_PACKED]		= engines_packed,
+	[ENGINE_FINGERING]	= engines_fingering
+};
@@ -59,65 +59,46 @@
 #include <wiz.h>
 #include <osc.h>
 #include <calibration.h>
+#include <sensors.h>
+#include <engines.h>
+#include <capture.h>
 
 static uint8_t adc1_raw_sequence [ADC_DUAL_LENGTH]; // ^corresponding raw ADC channels
 static uint8_t adc2_raw_sequence [ADC_DUAL_LENGTH]; // ^corresponding raw ADC channels
 static uint8_t adc3_raw_sequence [ADC_SING_LENGTH];
 
-static int16_t adc12_raw[2][ADC_DUAL_LENGTH*2] __attribute__((aligned(4))); // the dma temporary data array.
-static int16_t adc3_raw[2][ADC_SING_LENGTH] __attribute__((aligned(4)));
-
-static int16_t adc_raw[SENSOR_N];
-static float adc_val0[SENSOR_N];
-static float adc_val1[SENSOR_N];
-
-typedef struct _ADC_Filter ADC_Filter;
-typedef enum _ADC_State ADC_State;
-
-struct _ADC_Filter {
-	float Os;
-	float O0, O1;
-	float OO0, OO1;
-};
-
-#define FILT_STIFFNESS 16.f
-
-static ADC_Filter adc_filt[SENSOR_N] = {
-	[0] = { .Os = 1.f / FILT_STIFFNESS },
-	[1] = { .Os = 1.f / FILT_STIFFNESS },
-	[2] = { .Os = 1.f / FILT_STIFFNESS },
-	[3] = { .Os = 1.f / FILT_STIFFNESS },
-	[4] = { .Os = 1.f / FILT_STIFFNESS },
-	[5] = { .Os = 1.f / FILT_STIFFNESS },
-	[6] = { .Os = 1.f / FILT_STIFFNESS },
-	[7] = { .Os = 1.f / FILT_STIFFNESS },
-	[8] = { .Os = 1.f / FILT_STIFFNESS }
-};
-
-enum _ADC_State {
-	ADC_STATE_IDLE	= 0,
-	ADC_STATE_ON,
-	ADC_STATE_OFF,
-	ADC_STATE_SET
-};
-
-static ADC_State adc_state[SENSOR_N];
-
-static uint8_t order12 [ADC_DUAL_LENGTH*2];
-static uint8_t order3 [ADC_SING_LENGTH];
-
-static uint8_t adc1_sequence [ADC_DUAL_LENGTH] = {PA1, PA2, PA0, PA3}; // analog input pins read out by the ADC1
-static uint8_t adc2_sequence [ADC_DUAL_LENGTH] = {PA4, PA5, PA6, PA7}; // analog input pins read out by the ADC2
+// double buffered DMA targets in sensor order, each ADC fills its own contiguous slice
+static int16_t adc_frame [2][SENSOR_N] __attribute__((aligned(4)));
+
+#define BATCH_MTU 1472 // UDP payload of a non-fragmented Ethernet frame
+#define BATCH_RESET_FLUSH 1 // settings changed, pending frame closes the batch
+#define BATCH_RESET_DROP 2 // socket was closed, the start of the batch is gone
+
+#define ADC3_OFFSET 0 // sensor 0
+#define ADC2_OFFSET (ADC3_OFFSET + ADC_SING_LENGTH) // sensors 1-4
+#define ADC1_OFFSET (ADC2_OFFSET + ADC_DUAL_LENGTH) // sensors 5-8
+
+static uint8_t adc1_sequence [ADC_DUAL_LENGTH] = {PA3, PA0, PA2, PA1}; // analog input pins read out by the ADC1
+static uint8_t adc2_sequence [ADC_DUAL_LENGTH] = {PA7, PA6, PA5, PA4}; // analog input pins read out by the ADC2
 static uint8_t adc3_sequence [ADC_SING_LENGTH] = {PB0}; // analog input pins read out by the ADC3
 static uint8_t adc_unused [ADC_UNUSED_LENGTH] = {PB1};
-static uint8_t adc_order [ADC_LENGTH] = { 8, 4, 7, 3, 6, 2, 5, 1, 0 };
 
-static volatile uint_fast8_t adc12_dma_done = 0;
-static volatile uint_fast8_t adc12_dma_err = 0;
+static volatile uint_fast8_t adc1_dma_done = 0;
+static volatile uint_fast8_t adc1_dma_err = 0;
+static volatile uint_fast8_t adc2_dma_done = 0;
+static volatile uint_fast8_t adc2_dma_err = 0;
 static volatile uint_fast8_t adc3_dma_done = 0;
 static volatile uint_fast8_t adc3_dma_err = 0;
 static volatile uint_fast8_t adc_time_up = 1;
 static volatile uint_fast8_t adc_raw_ptr = 1;
+static volatile uint32_t adc_irq_tick; // sample instant of the running conversion
+static volatile uint32_t adc_irq_cycles;
+static uint32_t adc_tick; // sample instant of the last completed conversion
+static uint32_t adc_cycles;
+static uint16_t adc_reload; // nominal period in adc_timer ticks
+static float adc_tick_ns; // adc_timer tick duration
+static uint32_t adc_period_ns;
+static float adc_phase_i = 0.f; // integral part of the phase lock
 static volatile uint_fast8_t sync_should_request = 1; // send first request at boot
 static volatile uint_fast8_t sntp_should_listen = 0;
 static volatile uint_fast8_t ptp_should_request = 0;
@@ -131,6 +112,7 @@ static volatile uint_fast8_t dhcpc_should_listen = 0;
 static volatile uint_fast8_t dhcpc_needs_refresh = 0;
 static volatile uint_fast8_t mdns_timeout = 0;
 static volatile uint_fast8_t wiz_needs_attention = 0;
+static volatile uint_fast8_t batch_reset = 0;
 static volatile uint32_t wiz_irq_tick;
 static volatile int64_t wiz_ptp_tick;
 
@@ -182,31 +164,51 @@ wiz_irq()
 static void __CCM_TEXT__
 wiz_output_irq(uint8_t isr)
 {
-	output_should_listen = isr;
+	output_should_listen |= isr; // several IRQs may arrive before the main loop gets to them
+}
+
+/*
+ * a pending SEND_OK keeps INTn low until the main loop clears it, so a time
+ * sync datagram arriving meanwhile raises no edge of its own and would be
+ * stamped up to a frame period early; while sNTP or PTP run, the output
+ * socket therefore polls for send completion, at the cost of an SPI poll
+ * per frame and no queued output
+ */
+void
+output_irq_update()
+{
+	const uint8_t mask = WIZ_Sn_IR_RECV | WIZ_Sn_IR_TIMEOUT | WIZ_Sn_IR_CON | WIZ_Sn_IR_DISCON;
+	const uint_fast8_t sync = config.sntp.socket.enabled || config.ptp.event.enabled;
+
+	// completions still awaited via IRQ must arrive before the mask changes
+	if(sync)
+		udp_send_wait(SOCK_OUTPUT);
+
+	wiz_socket_irq_set(SOCK_OUTPUT, wiz_output_irq, sync ? mask : mask | WIZ_Sn_IR_SEND_OK);
 }
 
 static void __CCM_TEXT__
 wiz_config_irq(uint8_t isr)
 {
-	config_should_listen = isr;
+	config_should_listen |= isr;
 }
 
 static void __CCM_TEXT__
 wiz_debug_irq(uint8_t isr)
 {
-	debug_should_listen = isr;
+	debug_should_listen |= isr;
 }
 
 static void __CCM_TEXT__
 wiz_mdns_irq(uint8_t isr)
 {
-	mdns_should_listen = isr;
+	mdns_should_listen |= isr;
 }
 
 static void __CCM_TEXT__
 wiz_sntp_irq(uint8_t isr)
 {
-	sntp_should_listen = isr;
+	sntp_should_listen |= isr;
 }
 
 static void __CCM_TEXT__
@@ -219,31 +221,55 @@ ptp_timer_irq()
 static void __CCM_TEXT__
 wiz_ptp_event_irq(uint8_t isr)
 {
-	ptp_event_should_listen = isr;
+	ptp_event_should_listen |= isr;
 }
 
 static void __CCM_TEXT__
 wiz_ptp_general_irq(uint8_t isr)
 {
-	ptp_general_should_listen = isr;
+	ptp_general_should_listen |= isr;
 }
 
 static void __CCM_TEXT__
 wiz_dhcpc_irq(uint8_t isr)
 {
-	dhcpc_should_listen = isr;
+	dhcpc_should_listen |= isr;
+}
+
+// the last of the ADC DMA completions marks the sample instant
+static inline __always_inline void
+adc_dma_stamp()
+{
+	uint32_t cycles;
+
+	adc_irq_tick = sntp_uptime_cycles(&cycles);
+	adc_irq_cycles = cycles;
 }
 
 static void __CCM_TEXT__
-adc12_dma_irq()
+adc1_dma_irq()
 {
 	uint8_t isr = dma_get_isr_bits(DMA1, DMA_CH1);
 	dma_clear_isr_bits(DMA1, DMA_CH1);
 
 	if(isr & 0x8)
-		adc12_dma_err = 1;
+		adc1_dma_err = 1;
 
-	adc12_dma_done = 1;
+	adc_dma_stamp();
+	adc1_dma_done = 1;
+}
+
+static void __CCM_TEXT__
+adc2_dma_irq()
+{
+	uint8_t isr = dma_get_isr_bits(DMA2, DMA_CH1);
+	dma_clear_isr_bits(DMA2, DMA_CH1);
+
+	if(isr & 0x8)
+		adc2_dma_err = 1;
+
+	adc_dma_stamp();
+	adc2_dma_done = 1;
 }
 
 static void __CCM_TEXT__
@@ -255,24 +281,90 @@ adc3_dma_irq()
 	if(isr & 0x8)
 		adc3_dma_err = 1;
 
+	adc_dma_stamp();
 	adc3_dma_done = 1;
 }
 
+static inline __always_inline void
+adc_dma_rearm(dma_dev *dev, dma_channel tube, int16_t *dst, uint16_t len)
+{
+	dma_disable(dev, tube);
+	dma_set_mem_addr(dev, tube, dst);
+	dma_set_num_transfers(dev, tube, len);
+	dma_enable(dev, tube);
+}
+
 static inline __always_inline void
 adc_dma_run()
 {
-	adc12_dma_done = 0;
+	int16_t *frame = adc_frame[!adc_raw_ptr]; // the frame not being processed
+
+	adc_dma_rearm(DMA1, DMA_CH1, frame + ADC1_OFFSET, ADC_DUAL_LENGTH);
+	adc_dma_rearm(DMA2, DMA_CH1, frame + ADC2_OFFSET, ADC_DUAL_LENGTH);
+	adc_dma_rearm(DMA2, DMA_CH5, frame + ADC3_OFFSET, ADC_SING_LENGTH);
+
+	adc1_dma_done = 0;
+	adc2_dma_done = 0;
 	adc3_dma_done = 0;
-	ADC1->regs->CR |= ADC_CR_ADSTART; // start master(ADC1) and slave(ADC2) conversion
+	ADC1->regs->CR |= ADC_CR_ADSTART;
+	ADC2->regs->CR |= ADC_CR_ADSTART;
 	ADC3->regs->CR |= ADC_CR_ADSTART;
 }
 
 static inline __always_inline void
 adc_dma_block()
 { 
-	while( !adc12_dma_done || !adc3_dma_done ) // wait for all 3 ADCs to end
+	while( !adc1_dma_done || !adc2_dma_done || !adc3_dma_done ) // wait for all 3 ADCs to end
 		;
 	adc_raw_ptr ^= 1;
+	adc_tick = adc_irq_tick;
+	adc_cycles = adc_irq_cycles;
+}
+
+#define ADC_PHASE_KP 0.5f
+#define ADC_PHASE_KI 0.05f
+
+// PI loop steering the sample instants onto whole periods since PTP epoch
+static void __CCM_TEXT__
+adc_phase_lock()
+{
+	int32_t phase;
+
+	if(!config.sensors.rate || !config.sensors.phase_lock || !config.ptp.event.enabled
+		|| !ptp_phase(adc_tick, adc_cycles, adc_period_ns, &phase) )
+	{
+		adc_phase_i = 0.f;
+		if(config.sensors.rate) // free running at the nominal period
+		{
+			timer_set_reload(adc_timer, adc_reload);
+			timer_set_compare(adc_timer, TIMER_CH1, adc_reload);
+		}
+		return;
+	}
+
+	const float max = adc_period_ns / 8; // keeps the period within +-12.5%
+	float corr;
+
+	adc_phase_i += phase * ADC_PHASE_KI;
+	if(adc_phase_i > max)
+		adc_phase_i = max;
+	else if(adc_phase_i < -max)
+		adc_phase_i = -max;
+
+	corr = phase * ADC_PHASE_KP + adc_phase_i;
+	if(corr > max)
+		corr = max;
+	else if(corr < -max)
+		corr = -max;
+
+	// preloaded, takes effect with the next period, a late instant shortens it
+	int32_t reload = (int32_t)adc_reload - (int32_t)(corr / adc_tick_ns);
+	if(reload > 0xffff)
+		reload = 0xffff;
+	else if(reload < 1)
+		reload = 1;
+	timer_set_reload(adc_timer, reload);
+	timer_set_compare(adc_timer, TIMER_CH1, reload);
 }
 
 static void __CCM_TEXT__
@@ -303,148 +395,34 @@ mdns_cb(uint8_t *ip, uint16_t port, uint8_t *buf, uint16_t len)
 	mdns_dispatch(buf, len);
 }
 
-static osc_data_t *
-_out_dump_raw(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+// silences engines with sounding notes before handing over to another one
+static osc_data_t * __CCM_TEXT__
+output_frame(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
 {
-	uint_fast8_t i;
-	osc_data_t *bndl;
-	osc_data_t *itm;
-	osc_data_t *buf_ptr = buf;
-	
-	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
-		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-			buf_ptr = osc_set_path(buf_ptr, "/dmp");
-			buf_ptr = osc_set_fmt(buf_ptr, "ifffffffff");
-			buf_ptr = osc_set_int32(buf_ptr, frm);
-			for(i=0; i<SENSOR_N; i++)
-				//buf_ptr = osc_set_float(buf_ptr, adc_filt[i].OO1);
-				buf_ptr = osc_set_float(buf_ptr, adc_raw[i]);
-		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-	buf_ptr = osc_end_bundle(buf_ptr, bndl);
-
-	return buf_ptr;
-}
+	static uint_fast8_t engine_last = ENGINE_N;
+	const uint_fast8_t engine = config.output.engine;
+	const uint_fast8_t last = engine_last;
 
-static osc_data_t *
-_out_dump_val(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
-{
-	uint_fast8_t i;
-	osc_data_t *bndl;
-	osc_data_t *itm;
-	osc_data_t *buf_ptr = buf;
-	
-	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
-		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-			buf_ptr = osc_set_path(buf_ptr, "/val");
-			buf_ptr = osc_set_fmt(buf_ptr, "itfffffffff");
-			buf_ptr = osc_set_int32(buf_ptr, frm);
-			buf_ptr = osc_set_timetag(buf_ptr, now);
-			for(i=0; i<SENSOR_N; i++)
-				buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
-		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-	buf_ptr = osc_end_bundle(buf_ptr, bndl);
-
-	return buf_ptr;
-}
-
-static osc_data_t *
-_out_lossless(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
-{
-	uint_fast8_t i;
-	osc_data_t *bndl;
-	osc_data_t *itm;
-	osc_data_t *buf_ptr = buf;
-	char fmt[SENSOR_N+1];
-	char *fmt_ptr = fmt;
-	
-	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
-		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-			buf_ptr = osc_set_path(buf_ptr, "/frm");
-			buf_ptr = osc_set_fmt(buf_ptr, "it");
-			buf_ptr = osc_set_int32(buf_ptr, frm);
-			buf_ptr = osc_set_timetag(buf_ptr, now);
-		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-
-		for(i=0; i<SENSOR_N; i++)
-			switch(adc_state[i])
-			{
-				case ADC_STATE_IDLE:
-				case ADC_STATE_OFF:
-					break;
-				case ADC_STATE_ON:
-				case ADC_STATE_SET:
-					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-						buf_ptr = osc_set_path(buf_ptr, "/tok");
-						buf_ptr = osc_set_fmt(buf_ptr, "if");
-						buf_ptr = osc_set_int32(buf_ptr, i);
-						buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
-					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-					*fmt_ptr++ = 'i';
-					break;
-			}
-		*fmt_ptr = '\0';
-
-		buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-			buf_ptr = osc_set_path(buf_ptr, "/alv");
-			buf_ptr = osc_set_fmt(buf_ptr, fmt);
-			for(i=0; i<SENSOR_N; i++)
-				switch(adc_state[i])
-				{
-					case ADC_STATE_IDLE:
-					case ADC_STATE_OFF:
-						break;
-					case ADC_STATE_ON:
-					case ADC_STATE_SET:
-						buf_ptr = osc_set_int32(buf_ptr, i);
-						break;
-				}
-		buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-	buf_ptr = osc_end_bundle(buf_ptr, bndl);
+	engine_last = engine;
+	if(engine != last)
+	{
+		if(last == ENGINE_FINGERING)
+			return fingering_release(buf, offset);
+		if(last == ENGINE_MIDI)
+			return midi_release(buf, offset);
+	}
 
-	return buf_ptr;
+	return engines_frame_cb[engine](buf, frm, now, offset);
 }
 
-static osc_data_t *
-_out_lossy(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset)
+// batch state lives in loop(), others only request a reset
+void
+output_batch_reset(uint_fast8_t lost)
 {
-	uint_fast8_t i;
-	osc_data_t *bndl;
-	osc_data_t *itm;
-	osc_data_t *buf_ptr = buf;
-	
-	buf_ptr = osc_start_bundle(buf_ptr, offset, &bndl);
-		for(i=0; i<SENSOR_N; i++)
-			switch(adc_state[i])
-			{
-				case ADC_STATE_IDLE:
-					break;
-				case ADC_STATE_OFF:
-					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-						buf_ptr = osc_set_path(buf_ptr, "/off");
-						buf_ptr = osc_set_fmt(buf_ptr, "i");
-						buf_ptr = osc_set_int32(buf_ptr, i);
-					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-					break;
-				case ADC_STATE_ON:
-					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-						buf_ptr = osc_set_path(buf_ptr, "/on");
-						buf_ptr = osc_set_fmt(buf_ptr, "if");
-						buf_ptr = osc_set_int32(buf_ptr, i);
-						buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
-					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-					break;
-				case ADC_STATE_SET:
-					buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-						buf_ptr = osc_set_path(buf_ptr, "/set");
-						buf_ptr = osc_set_fmt(buf_ptr, "if");
-						buf_ptr = osc_set_int32(buf_ptr, i);
-						buf_ptr = osc_set_float(buf_ptr, adc_val1[i]);
-					buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-					break;
-			}
-	buf_ptr = osc_end_bundle(buf_ptr, bndl);
-
-	return buf_ptr;
+	if(lost)
+		batch_reset = BATCH_RESET_DROP;
+	else if(!batch_reset)
+		batch_reset = BATCH_RESET_FLUSH;
 }
 
 void
@@ -455,6 +433,14 @@ loop()
 	uint_fast8_t first = 1;
 	OSC_Timetag offset;
 	uint32_t frm = 1;
+	uint_fast8_t valve_cnt = 0;
+
+	// multi-frame datagrams are appended to the TX memory and sent as one
+	uint_fast8_t batched = 0; // pending output is part of a batch
+	uint_fast8_t batch_send = 0; // pending output completes its batch
+	uint_fast8_t batch_n = 0;
+	uint_fast16_t batch_size = 0;
+	OSC_Timetag batch_t0 = 0ULLK;
 
 	osc_data_t *bndl;
 	osc_data_t *itm;
@@ -488,90 +474,90 @@ loop()
 
 		if(config.output.osc.socket.enabled && (wiz_socket_state[SOCK_OUTPUT] == WIZ_SOCKET_STATE_OPEN) )
 		{
-			osc_send_nonblocking(&config.output.osc, BUF_O_BASE(!buf_o_ptr), len);
+			// settings changed or socket reopened since the pending frame was built
+			if(batch_reset)
+			{
+				if(batched && (batch_reset == BATCH_RESET_DROP) )
+					len = 0;
+				else if(batched)
+					batch_send = 1;
+				batch_n = 0;
+				batch_reset = 0;
+			}
 
-			// fill adc_raw array	
-			uint_fast8_t i;
-			for(i=0; i<ADC_DUAL_LENGTH*2; i++)
-				adc_raw[order12[i]] = adc12_raw[adc_raw_ptr][i];
-			for(i=0; i<ADC_SING_LENGTH; i++)
-				adc_raw[order3[i]] = adc3_raw[adc_raw_ptr][i];
+			if(!len)
+				; // pending frame dropped
+			else if(batched)
+				udp_append_nonblocking(SOCK_OUTPUT, BUF_O_BASE(!buf_o_ptr), len, batch_send);
+			else if(config.output.queue && (config.output.osc.mode == OSC_MODE_UDP) )
+				udp_queue_nonblocking(SOCK_OUTPUT, BUF_O_BASE(!buf_o_ptr), len);
+			else
+				osc_send_nonblocking(&config.output.osc, BUF_O_BASE(!buf_o_ptr), len);
+
+			// process the frame just released by DMA in place
+			adc_raw = adc_frame[adc_raw_ptr];
 
 			if(calibrating)
 				range_calibrate(adc_raw);
 
-			for(i=0; i<SENSOR_N; i++)
+			// filter, normalize, linearize and update state, valves decimated
+			uint_fast8_t groups = SENSORS_GROUP_BREATH;
+			if(++valve_cnt >= config.sensors.valve_divider)
 			{
-				ADC_Filter *filt = &adc_filt[i];
-
-				// filter signal
-				filt->O1 = adc_raw[i];
-				filt->OO1 = filt->Os * (filt->O0 + filt->O1) / 2.f + filt->OO0 * (1.f - filt->Os);
-				filt->O0 = filt->O1;
-				filt->OO0 = filt->OO1;
-
-				// normalize
-				adc_val1[i] = (filt->OO1 - range.Bmin[i]) * range.W[i];
-
-				// linearization skip for pressure sensor
-				if(i != SENSOR_N-1)
-					adc_val1[i] = range.C[i][0] * cbrtf(adc_val1[i])
-											+ range.C[i][1] * sqrtf(adc_val1[i])
-											+ range.C[i][2] *       adc_val1[i];
-
-				// update state
-				if(adc_val1[i] > 0.f)
-				{
-					if(adc_val0[i] > 0.f)
-						adc_state[i] = ADC_STATE_SET;
-					else
-						adc_state[i] = ADC_STATE_ON;
-				}
-				else // adc_val1[i] <= 0.f
-				{
-					if(adc_val0[i] > 0.f)
-						adc_state[i] = ADC_STATE_OFF;
-					else
-						adc_state[i] = ADC_STATE_IDLE;
-				}
-				adc_val0[i] = adc_val1[i];
+				groups |= SENSORS_GROUP_VALVES;
+				valve_cnt = 0;
 			}
+			sensors_update(groups);
 
-			// refresh timetag
+			// refresh timetag from sample instant
 			if(config.sntp.socket.enabled)
-				sntp_timestamp_refresh(systick_uptime(), &now, &offset);
+				sntp_timestamp_refresh_cycles(adc_tick, adc_cycles, &now, &offset);
 			else if(config.ptp.event.enabled)
-				ptp_timestamp_refresh(ptp_uptime(), &now, &offset);
+				ptp_timestamp_refresh_cycles(adc_tick, adc_cycles, &now, &offset);
 			else // neither sNTP nor PTP active
-				sntp_timestamp_refresh(systick_uptime(), &now, &offset);
+				sntp_timestamp_refresh_cycles(adc_tick, adc_cycles, &now, &offset);
 
 			frm++;
 
+			if(capturing)
+				capture_frame(frm, now, offset);
+
 			// construct OSC output
 			buf_ptr = BUF_O_OFFSET(buf_o_ptr);
-			//buf_ptr = osc_start_bundle(buf_ptr, OSC_IMMEDIATE, &bndl);
-
-				//buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-					buf_ptr = _out_dump_raw(buf_ptr, frm, now, offset);
-				//buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-
-				//buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-				//	buf_ptr = _out_dump_val(buf_ptr, frm, now, offset);
-				//buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-
-				//buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-				//	buf_ptr = _out_lossless(buf_ptr, frm, now, offset);
-				//buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-
-				//buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
-				//	buf_ptr = _out_lossy(buf_ptr, frm, now, offset);
-				//buf_ptr = osc_end_bundle_item(buf_ptr, itm);
-
-			//buf_ptr = osc_end_bundle(buf_ptr, bndl);
+			batched = batch_n || ( (config.output.batch.frames > 1) && (config.output.osc.mode == OSC_MODE_UDP) );
+			if(batched)
+			{
+				// frames are items of an outer bundle, each keeping its own timetag
+				if(batch_n == 0)
+				{
+					buf_ptr = osc_start_bundle(buf_ptr, OSC_IMMEDIATE, &bndl);
+					batch_t0 = now;
+					batch_size = 0;
+				}
+				buf_ptr = osc_start_bundle_item(buf_ptr, &itm);
+					buf_ptr = output_frame(buf_ptr, frm, now, offset);
+				buf_ptr = osc_end_bundle_item(buf_ptr, itm);
+			}
+			else
+				buf_ptr = output_frame(buf_ptr, frm, now, offset);
 			len = buf_ptr - BUF_O_OFFSET(buf_o_ptr);
 
-			osc_send_block(&config.output.osc);
+			if(batched)
+			{
+				batch_n++;
+				batch_size += len;
+				batch_send = (batch_n >= config.output.batch.frames)
+					|| (now - batch_t0 >= config.output.batch.latency)
+					|| (batch_size + len > BATCH_MTU); // next frame would not fit
+				if(batch_send)
+					batch_n = 0;
+			}
+
+			osc_send_block(&config.output.osc); // only waits for SPI, SEND_OK is awaited before next SEND
 			buf_o_ptr ^= 1;
+
+			if(capturing)
+				capture_flush();
 		}
 
 		// handle WIZnet IRQs XXX check manually if we should have missed an interrupt
@@ -586,14 +572,18 @@ loop()
 		// run osc config server
 		if(config_should_listen)
 		{
-			if(config_should_listen & WIZ_Sn_IR_CON) // TCP only
+			// clear before handling, callbacks may fire again from within the sends
+			const uint8_t isr = config_should_listen;
+			config_should_listen = 0;
+
+			if(isr & WIZ_Sn_IR_CON) // TCP only
 			{
 				wiz_socket_state[SOCK_CONFIG] = WIZ_SOCKET_STATE_OPEN;
 				udp_get_remote(SOCK_CONFIG, config.config.osc.socket.ip, &config.config.osc.socket.port[DST_PORT]);
 				udp_update_read_write_pointers(SOCK_CONFIG);
 				debug_str("config connect");
 			}
-			if( (config_should_listen & WIZ_Sn_IR_TIMEOUT) || (config_should_listen & WIZ_Sn_IR_DISCON) )
+			if( (isr & WIZ_Sn_IR_TIMEOUT) || (isr & WIZ_Sn_IR_DISCON) )
 			{
 				uint8_t enabled = config.config.osc.socket.enabled;
 				config_enable(0);
@@ -601,21 +591,24 @@ loop()
 					config_enable(1);
 				debug_str("config ARPto or TCP disconect");
 			}
-			else if( (config_should_listen & WIZ_Sn_IR_RECV) && (wiz_socket_state[SOCK_CONFIG] == WIZ_SOCKET_STATE_OPEN) )
+			else if( (isr & WIZ_Sn_IR_RECV) && (wiz_socket_state[SOCK_CONFIG] == WIZ_SOCKET_STATE_OPEN) )
 				osc_dispatch(&config.config.osc, BUF_I_BASE(buf_i_ptr), config_cb);
-			config_should_listen = 0;
 		}
 
 		if(output_should_listen)
 		{
-			if(output_should_listen & WIZ_Sn_IR_CON) // TCP only
+			const uint8_t isr = output_should_listen;
+			output_should_listen = 0;
+
+			if(isr & WIZ_Sn_IR_CON) // TCP only
 			{
 				wiz_socket_state[SOCK_OUTPUT] = WIZ_SOCKET_STATE_OPEN;
 				udp_get_remote(SOCK_OUTPUT, config.output.osc.socket.ip, &config.output.osc.socket.port[DST_PORT]);
 				udp_update_read_write_pointers(SOCK_OUTPUT);
 				debug_str("output connect");
 			}
-			if( (output_should_listen & WIZ_Sn_IR_TIMEOUT) || (output_should_listen & WIZ_Sn_IR_DISCON) )
+			// an ARPto on UDP only fails a single SEND, the next one will try again
+			if( ( (isr & WIZ_Sn_IR_TIMEOUT) && config.output.osc.mode) || (isr & WIZ_Sn_IR_DISCON) )
 			{
 				uint8_t enabled = config.output.osc.socket.enabled;
 				output_enable(0);
@@ -623,45 +616,46 @@ loop()
 					output_enable(1);
 				debug_str("output ARPto or TCP disconect");
 			}
-			else if( (output_should_listen & WIZ_Sn_IR_RECV) && (wiz_socket_state[SOCK_OUTPUT] == WIZ_SOCKET_STATE_OPEN) )
+			else if( (isr & WIZ_Sn_IR_RECV) && (wiz_socket_state[SOCK_OUTPUT] == WIZ_SOCKET_STATE_OPEN) )
 				osc_ignore(config.output.osc.socket.sock);
-			output_should_listen = 0;
 		}
 
 		if(debug_should_listen)
 		{
-			if(debug_should_listen & WIZ_Sn_IR_CON) // TCP only
+			const uint8_t isr = debug_should_listen;
+			debug_should_listen = 0;
+
+			if(isr & WIZ_Sn_IR_CON) // TCP only
 			{
 				wiz_socket_state[SOCK_DEBUG] = WIZ_SOCKET_STATE_OPEN;
 				udp_get_remote(SOCK_DEBUG, config.debug.osc.socket.ip, &config.debug.osc.socket.port[DST_PORT]);
 				udp_update_read_write_pointers(SOCK_DEBUG);
 			}
-			if( (debug_should_listen & WIZ_Sn_IR_TIMEOUT) || (debug_should_listen & WIZ_Sn_IR_DISCON) )
+			if( (isr & WIZ_Sn_IR_TIMEOUT) || (isr & WIZ_Sn_IR_DISCON) )
 			{
 				uint8_t enabled = config.debug.osc.socket.enabled;
 				debug_enable(0);
 				if(config.debug.osc.mode && config.debug.osc.server && enabled)
 					debug_enable(1);
 			}
-			else if( (debug_should_listen & WIZ_Sn_IR_RECV) && (wiz_socket_state[SOCK_DEBUG] == WIZ_SOCKET_STATE_OPEN) )
+			else if( (isr & WIZ_Sn_IR_RECV) && (wiz_socket_state[SOCK_DEBUG] == WIZ_SOCKET_STATE_OPEN) )
 				osc_ignore(config.debug.osc.socket.sock);
-			debug_should_listen = 0;
 		}
 		
 		// run sntp client
 		if(config.sntp.socket.enabled)
 		{
-			if(sntp_should_listen & WIZ_Sn_IR_TIMEOUT)
+			const uint8_t isr = sntp_should_listen;
+			sntp_should_listen = 0;
+
+			if(isr & WIZ_Sn_IR_TIMEOUT)
 			{
 				sntp_enable(0);
 				debug_str("sntp ARPto");
 			}
 			// listen for sntp request answer
-			else if(sntp_should_listen & WIZ_Sn_IR_RECV)
-			{
+			else if(isr & WIZ_Sn_IR_RECV)
 				udp_dispatch(config.sntp.socket.sock, BUF_I_BASE(buf_i_ptr), sntp_cb);
-				sntp_should_listen = 0;
-			}
 
 			// send sntp request
 			if(sync_should_request)
@@ -678,14 +672,14 @@ loop()
 		{
 			if(ptp_event_should_listen & WIZ_Sn_IR_RECV)
 			{
-				udp_dispatch(config.ptp.event.sock, BUF_I_BASE(buf_i_ptr), ptp_cb);
 				ptp_event_should_listen = 0;
+				udp_dispatch(config.ptp.event.sock, BUF_I_BASE(buf_i_ptr), ptp_cb);
 			}
 
 			if(ptp_general_should_listen & WIZ_Sn_IR_RECV)
 			{
-				udp_dispatch(config.ptp.general.sock, BUF_I_BASE(buf_i_ptr), ptp_cb);
 				ptp_general_should_listen = 0;
+				udp_dispatch(config.ptp.general.sock, BUF_I_BASE(buf_i_ptr), ptp_cb);
 			}
 
 			if(ptp_should_request)
@@ -701,8 +695,8 @@ loop()
 			// ARPto does not exist for multicast connections
 			if(mdns_should_listen & WIZ_Sn_IR_RECV)
 			{
-				udp_dispatch(config.mdns.socket.sock, BUF_I_BASE(buf_i_ptr), mdns_cb);
 				mdns_should_listen = 0;
+				udp_dispatch(config.mdns.socket.sock, BUF_I_BASE(buf_i_ptr), mdns_cb);
 			}
 
 			if(mdns_timeout)
@@ -738,6 +732,7 @@ loop()
 		*/
 
 		adc_dma_block();
+		adc_phase_lock();
 
 		if(config.sensors.rate)
 			while(!adc_time_up)
@@ -748,16 +743,30 @@ loop()
 void
 adc_timer_reconfigure()
 {
-	// this scheme is good for rates in the range of 20-2000+
-	uint16_t prescaler = 50-1;
-	uint16_t reload = 72e6 / (config.sensors.rate * 50);
+	if(!config.sensors.rate) // unthrottled
+		return;
+
+	// smallest prescaler that fits the 16-bit reload, for the finest phase lock steps,
+	// with headroom for the +12.5% phase lock correction
+	uint32_t cycles = 72e6 / config.sensors.rate;
+	uint16_t prescaler = (cycles + cycles/8) >> 16;
+	uint16_t reload = cycles / (prescaler + 1);
 	uint16_t compare = reload;
 
+	adc_reload = reload;
+	adc_tick_ns = 1e9 / 72e6 * (prescaler + 1);
+	adc_period_ns = 1e9 / config.sensors.rate;
+	adc_phase_i = 0.f;
+
 	timer_set_prescaler(adc_timer, prescaler);
 	timer_set_reload(adc_timer, reload);
 	timer_set_mode(adc_timer, TIMER_CH1, TIMER_OUTPUT_COMPARE);
 	timer_set_compare(adc_timer, TIMER_CH1, compare);
 	timer_attach_interrupt(adc_timer, TIMER_CH1, adc_timer_irq);
+
+	// reload and compare are preloaded, so the phase lock can adjust the next period anytime
+	adc_timer->regs.adv->CR1 |= TIMER_CR1_ARPE;
+	adc_timer->regs.adv->CCMR1 |= TIMER_CCMR1_OC1PE;
 	timer_generate_update(adc_timer);
 
 	nvic_irq_set_priority(NVIC_TIMER1_CC, ADC_TIMER_PRIORITY);
@@ -944,28 +953,12 @@ setup()
 	dma_init(DMA2);
 
 	// initialize WIZnet W5200/W5500
-	uint8_t tx_mem[WIZ_MAX_SOCK_NUM] = {
-		[SOCK_DHCPC]	= 1, // = SOCK_ARP
-		[SOCK_SNTP]		= 1,
-		[SOCK_PTP_EV] = 1,
-		[SOCK_PTP_GE] = 1,
-		[SOCK_OUTPUT]	= 8,
-		[SOCK_CONFIG]	= 2,
-		[SOCK_DEBUG]	= 1,
-		[SOCK_MDNS]		= 1,
-	};
-	uint8_t rx_mem[WIZ_MAX_SOCK_NUM] = {
-		[SOCK_DHCPC]	= 1, // = SOCK_ARP
-		[SOCK_SNTP]		= 1,
-		[SOCK_PTP_EV] = 1,
-		[SOCK_PTP_GE] = 1,
-		[SOCK_OUTPUT]	= 8,
-		[SOCK_CONFIG]	= 2,
-		[SOCK_DEBUG]	= 1,
-		[SOCK_MDNS]		= 1,
-	};
+	uint8_t tx_mem[WIZ_MAX_SOCK_NUM];
+	uint8_t rx_mem[WIZ_MAX_SOCK_NUM];
+	sockets_partition(tx_mem, rx_mem); // is redone whenever a service is toggled
 
 	wiz_init(PIN_MAP[UDP_SS].gpio_device, PIN_MAP[UDP_SS].gpio_bit);
+	wiz_spi_adapt(config.comm.spi_adapt);
 
 	// wait for link up before proceeding
 	while(!wiz_link_up()) // TODO monitor this and go to sleep mode when link is down
@@ -994,7 +987,7 @@ setup()
 	wiz_socket_irq_set(SOCK_SNTP, wiz_sntp_irq, wiz_udp_irq_mask);
 	wiz_socket_irq_set(SOCK_PTP_EV, wiz_ptp_event_irq, wiz_udp_multicast_irq_mask);
 	wiz_socket_irq_set(SOCK_PTP_GE, wiz_ptp_general_irq, wiz_udp_multicast_irq_mask);
-	wiz_socket_irq_set(SOCK_OUTPUT, wiz_output_irq, wiz_tcp_irq_mask);
+	output_irq_update(); // send completion via IRQ unless time sync runs
 	wiz_socket_irq_set(SOCK_CONFIG, wiz_config_irq, wiz_tcp_irq_mask);
 	wiz_socket_irq_set(SOCK_DEBUG, wiz_debug_irq, wiz_tcp_irq_mask);
 	wiz_socket_irq_set(SOCK_MDNS, wiz_mdns_irq, wiz_udp_multicast_irq_mask);
@@ -1005,6 +998,11 @@ setup()
 	timer_init(adc_timer);
 	timer_pause(adc_timer);
 	adc_timer_reconfigure();
+	breath_configure(&config.sensors.breath, config.sensors.rate);
+	autozero_configure(&config.sensors.autozero, config.sensors.rate);
+	midi_configure(&config.output.midi);
+	packed_configure(config.output.packed_q15, config.output.packed_fec);
+	fingering_configure(&config.output.fingering);
 
 	timer_init(sync_timer);
 
@@ -1053,54 +1051,61 @@ setup()
 	for(i=0; i<ADC_SING_LENGTH; i++)
 		adc3_raw_sequence[i] = PIN_MAP[adc3_sequence[i]].adc_channel;
 
-	for(i=0; i<ADC_DUAL_LENGTH*2; i++)
-		order12[i] = adc_order[i];
-
-	for(i=0; i<ADC_SING_LENGTH; i++)
-		order3[i] = adc_order[ADC_DUAL_LENGTH*2+i];
-
 	// set up ADC DMA tubes
 	int status;
 
-	// set channels in register
+	// ADCs run independently, each with its own DMA tube into its slice of adc_frame
 	adc_set_conv_seq(ADC1, adc1_raw_sequence, ADC_DUAL_LENGTH);
-	adc_set_conv_seq(ADC2, adc2_raw_sequence, ADC_DUAL_LENGTH);
 
-	ADC12_BASE->CCR |= ADC_MDMA_MODE_ENABLE_12_10_BIT; // enable ADC DMA in 12-bit dual mode
-	ADC12_BASE->CCR |= ADC_CCR_DMACFG; // enable ADC circular mode for use with DMA
-	ADC12_BASE->CCR |= ADC_MODE_DUAL_REGULAR_ONLY; // set DMA dual mode to regular channels only
+	ADC1->regs->CFGR |= ADC_CFGR_DMAEN; // enable DMA request
+	ADC1->regs->CFGR |= ADC_CFGR_DMACFG; // enable ADC circular mode for use with DMA
 
 	adc_enable(ADC1);
-	adc_enable(ADC2);
 
 	// set up DMA tube
-	adc_tube12.tube_dst =(void *)adc12_raw;
-	status = dma_tube_cfg(DMA1, DMA_CH1, &adc_tube12);
+	adc_tube1.tube_dst = adc_frame[0] + ADC1_OFFSET;
+	adc_tube1.tube_nr_xfers = ADC_DUAL_LENGTH;
+	status = dma_tube_cfg(DMA1, DMA_CH1, &adc_tube1);
 	ASSERT(status == DMA_TUBE_CFG_SUCCESS);
 
 	dma_set_priority(DMA1, DMA_CH1, DMA_PRIORITY_MEDIUM);    //Optional
-	dma_set_num_transfers(DMA1, DMA_CH1, ADC_DUAL_LENGTH*2);
-	dma_attach_interrupt(DMA1, DMA_CH1, adc12_dma_irq);
-	dma_enable(DMA1, DMA_CH1);                //CCR1 EN bit 0
+	dma_attach_interrupt(DMA1, DMA_CH1, adc1_dma_irq);
 	nvic_irq_set_priority(NVIC_DMA_CH1, ADC_DMA_PRIORITY);
 
+	adc_set_conv_seq(ADC2, adc2_raw_sequence, ADC_DUAL_LENGTH);
+
+	ADC2->regs->CFGR |= ADC_CFGR_DMAEN; // enable DMA request
+	ADC2->regs->CFGR |= ADC_CFGR_DMACFG; // enable ADC circular mode for use with DMA
+
+	adc_enable(ADC2);
+
+	// set up DMA tube
+	adc_tube2.tube_dst = adc_frame[0] + ADC2_OFFSET;
+	adc_tube2.tube_nr_xfers = ADC_DUAL_LENGTH;
+	status = dma_tube_cfg(DMA2, DMA_CH1, &adc_tube2);
+	ASSERT(status == DMA_TUBE_CFG_SUCCESS);
+
+	dma_set_priority(DMA2, DMA_CH1, DMA_PRIORITY_MEDIUM);
+	dma_attach_interrupt(DMA2, DMA_CH1, adc2_dma_irq);
+	nvic_irq_set_priority(NVIC_DMA2_CH1, ADC_DMA_PRIORITY);
+
 	adc_set_conv_seq(ADC3, adc3_raw_sequence, ADC_SING_LENGTH);
 
 	ADC3->regs->CFGR |= ADC_CFGR_DMAEN; // enable DMA request
-	ADC3->regs->CFGR |= ADC_CFGR_DMACFG, // enable ADC circular mode for use with DMA
+	ADC3->regs->CFGR |= ADC_CFGR_DMACFG; // enable ADC circular mode for use with DMA
 
 	adc_enable(ADC3);
 
 	// set up DMA tube
-	adc_tube3.tube_dst =(void *)adc3_raw;
+	adc_tube3.tube_dst = adc_frame[0] + ADC3_OFFSET;
+	adc_tube3.tube_nr_xfers = ADC_SING_LENGTH;
 	status = dma_tube_cfg(DMA2, DMA_CH5, &adc_tube3);
 	ASSERT(status == DMA_TUBE_CFG_SUCCESS);
 
 	dma_set_priority(DMA2, DMA_CH5, DMA_PRIORITY_MEDIUM);
-	dma_set_num_transfers(DMA2, DMA_CH5, ADC_SING_LENGTH*2);
 	dma_attach_interrupt(DMA2, DMA_CH5, adc3_dma_irq);
-	dma_enable(DMA2, DMA_CH5);
-	nvic_irq_set_priority(NVIC_DMA_CH5, ADC_DMA_PRIORITY);
+	nvic_irq_set_priority(NVIC_DMA2_CH5, ADC_DMA_PRIORITY);
+	// tubes are (re)enabled per frame by adc_dma_run
 
 	pin_write_bit(CHIM_LED_PIN, 1);
 	//DEBUG("si", "config_size", sizeof(Config));
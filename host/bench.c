@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+/*
+ * benchmarks the sensor pipeline and output engines on the host,
+ * reports ns/frame per engine and number of active sensors
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <osc.h>
+#include <sensors.h>
+#include <calibration.h>
+#include <engines.h>
+
+#include "pipeline.h"
+
+#define BENCH_BUFSIZE 0x800
+#define BENCH_FRAMES 200000
+
+typedef struct _Engine Engine;
+
+struct _Engine {
+	const char *name;
+	Engine_Frame_Cb cb;
+};
+
+static const Engine engines [] = {
+	{"pipeline", NULL}, // sensors_update only
+	{"dump_raw", engines_dump_raw},
+	{"dump_val", engines_dump_val},
+	{"lossless", engines_lossless},
+	{"lossy", engines_lossy},
+	{"midi", engines_midi},
+	{"packed", engines_packed},
+	{"fingering", engines_fingering},
+	{NULL, NULL}
+};
+
+static int16_t frame [SENSOR_N];
+static const Breath_Config breath_config = BREATH_CONFIG_DEFAULT;
+static const Autozero_Config autozero_config = AUTOZERO_CONFIG_DEFAULT;
+static const MIDI_Config midi_config = MIDI_CONFIG_DEFAULT;
+static const Fingering_Config fingering_config = FINGERING_CONFIG_DEFAULT;
+
+static osc_data_t buf [BENCH_BUFSIZE] __attribute__((aligned(4)));
+static volatile size_t sink; // keeps the serializers from being optimized away
+
+static void
+_raw_fill(int32_t frm, uint_fast8_t active)
+{
+	uint_fast8_t i;
+
+	// active sensors move slowly within the upper half of the range, the others rest
+	for(i=0; i<SENSOR_N; i++)
+		adc_raw[i] = i < active ? 0x800 + ((frm + i*64) & 0x3ff) : 0;
+}
+
+static double
+_bench(const Engine *engine, uint_fast8_t active, uint32_t frames)
+{
+	struct timespec t0, t1;
+	OSC_Timetag now = 1ULL << 32;
+	OSC_Timetag offset = now;
+	int32_t frm;
+
+	memset(adc_filt, 0, sizeof(adc_filt));
+	for(frm=0; frm<SENSOR_N; frm++)
+		adc_filt[frm].Os = 1.f / 16.f;
+
+	// warm up filters and caches
+	for(frm=0; frm<1000; frm++)
+	{
+		_raw_fill(frm, active);
+		sensors_update(SENSORS_GROUP_ALL);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(frm=0; frm<frames; frm++)
+	{
+		_raw_fill(frm, active);
+		sensors_update(SENSORS_GROUP_ALL);
+		if(engine->cb)
+			sink = engine->cb(buf, frm, now, offset) - buf;
+		now += 0x418937ULL; // ~1ms
+		offset = now;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return ((t1.tv_sec - t0.tv_sec)*1e9 + (t1.tv_nsec - t0.tv_nsec)) / frames;
+}
+
+int
+main(int argc, char **argv)
+{
+	uint32_t frames = BENCH_FRAMES;
+	const Engine *engine;
+	uint_fast8_t active;
+	int c;
+
+	while((c = getopt(argc, argv, "n:")) != -1)
+		switch(c)
+		{
+			case 'n':
+				if(atoi(optarg) < 1)
+				{
+					fprintf(stderr, "frames must be at least 1\n");
+					return -1;
+				}
+				frames = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n frames]\n", argv[0]);
+				return -1;
+		}
+
+	pipeline_range_reset();
+	adc_raw = frame;
+	breath_configure(&breath_config, BREATH_RATE_DEFAULT);
+	autozero_configure(&autozero_config, BREATH_RATE_DEFAULT);
+	midi_configure(&midi_config);
+	fingering_configure(&fingering_config);
+
+	printf("%-10s", "active");
+	for(engine=engines; engine->name; engine++)
+		printf(" %10s", engine->name);
+	printf("\n");
+
+	for(active=0; active<=SENSOR_N; active++)
+	{
+		printf("%-10u", (unsigned)active);
+		for(engine=engines; engine->name; engine++)
+			printf(" %10.1f", _bench(engine, active, frames));
+		printf("\n");
+	}
+	printf("(ns/frame, %u frames each)\n", frames);
+
+	return 0;
+}
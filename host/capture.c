@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+/*
+ * records the /capture/ messages of the debug socket (UDP mode) into a capture file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <osc.h>
+#include <capture.h>
+
+#define CAPTURE_PORT 6666 // default debug port
+#define CAPTURE_BUFSIZE 0x800
+
+static volatile sig_atomic_t done = 0;
+
+static void
+_sigint(int sig)
+{
+	done = 1;
+}
+
+int
+main(int argc, char **argv)
+{
+	uint16_t port = CAPTURE_PORT;
+	const char *path = NULL;
+	int c;
+
+	while((c = getopt(argc, argv, "p:")) != -1)
+		switch(c)
+		{
+			case 'p':
+				port = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-p port] file\n", argv[0]);
+				return -1;
+		}
+	if(optind >= argc)
+	{
+		fprintf(stderr, "usage: %s [-p port] file\n", argv[0]);
+		return -1;
+	}
+	path = argv[optind];
+
+	FILE *f = fopen(path, "wb");
+	if(!f)
+	{
+		perror("fopen");
+		return -1;
+	}
+
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr.s_addr = htonl(INADDR_ANY)
+	};
+	if( (sock < 0) || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) )
+	{
+		perror("socket");
+		fclose(f);
+		return -1;
+	}
+
+	// no SA_RESTART, lets recv return on SIGINT
+	struct sigaction sa = { .sa_handler = _sigint };
+	sigaction(SIGINT, &sa, NULL);
+
+	osc_data_t buf [CAPTURE_BUFSIZE] __attribute__((aligned(4)));
+	uint32_t frames = 0;
+	while(!done)
+	{
+		ssize_t len = recv(sock, buf, CAPTURE_BUFSIZE, 0);
+		if(len <= 0)
+			continue;
+
+		if(strncmp((const char *)buf, "/capture/", 9)) // ignore other debug messages
+			continue;
+
+		if(!strcmp((const char *)buf, "/capture/frames"))
+			frames += CAPTURE_BATCH;
+
+		// same framing as osc.tcp
+		uint32_t size = htonl(len);
+		fwrite(&size, sizeof(uint32_t), 1, f);
+		fwrite(buf, len, 1, f);
+	}
+
+	fprintf(stderr, "%u frames captured\n", frames);
+
+	close(sock);
+	fclose(f);
+
+	return 0;
+}
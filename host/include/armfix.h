@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _ARMFIX_H_
+#define _ARMFIX_H_
+
+/*
+ * host replacement for include/armfix.h
+ *
+ * host compilers lack ISO/IEC TR 18037 fixed point support, the 32.32 timetag
+ * is kept as its raw bit pattern instead, which is what goes on the wire anyway
+ */
+
+#include <stdint.h>
+
+#include <netdef.h>
+
+typedef uint64_t fix_32_32_t;
+typedef int64_t fix_s31_32_t;
+
+#endif // _ARMFIX_H_
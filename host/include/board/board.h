@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _BOARD_BOARD_H_
+#define _BOARD_BOARD_H_
+
+/*
+ * host replacement for board/board.h, used by the WIZnet simulator,
+ * only the pins of the WIZnet interface of REVISION 4 are wired
+ */
+
+#define BOARD_SPI3_NSS_PIN	0
+#define PA14								1
+#define PA8									2
+#define PB2									3
+
+#define BOARD_NR_GPIO_PINS	4
+
+#endif // _BOARD_BOARD_H_
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _LIBMAPLE_DMA_H_
+#define _LIBMAPLE_DMA_H_
+
+/*
+ * host replacement for libmaple/dma.h, used by the WIZnet simulator,
+ * enabling a SPI TX tube runs the whole transfer and its ISR synchronously
+ */
+
+#include <stdint.h>
+
+#include <libmaple/util.h>
+
+typedef struct dma_dev dma_dev;
+
+typedef enum dma_tube {
+	DMA_CH1 = 1,
+	DMA_CH2,
+	DMA_CH3,
+	DMA_CH4,
+	DMA_CH5,
+	DMA_CH6,
+	DMA_CH7
+} dma_tube;
+
+typedef enum dma_priority {
+	DMA_PRIORITY_LOW = 0,
+	DMA_PRIORITY_MEDIUM,
+	DMA_PRIORITY_HIGH,
+	DMA_PRIORITY_VERY_HIGH
+} dma_priority;
+
+typedef struct dma_tube_reg_map {
+	volatile uint32_t CCR;
+	volatile uint32_t CNDTR;
+	volatile uint32_t CPAR;
+	volatile uint32_t CMAR;
+} dma_tube_reg_map;
+
+typedef struct dma_tube_config {
+	const void *tube_src;
+	int tube_src_size;
+	void *tube_dst;
+	int tube_dst_size;
+	unsigned tube_nr_xfers;
+	unsigned tube_flags;
+	void *target_data;
+	unsigned tube_req_src;
+} dma_tube_config;
+
+#define DMA_TUBE_CFG_SUCCESS 0
+
+#define DMA_CCR_TCIE (1U << 1)
+#define DMA_CCR_TEIE (1U << 3)
+#define DMA_CCR_MINC (1U << 7)
+
+#define DMA_ISR_TCIF (1U << 1)
+#define DMA_ISR_TEIF (1U << 3)
+
+extern dma_dev *const DMA1;
+
+int dma_tube_cfg(dma_dev *dev, dma_tube tube, dma_tube_config *cfg);
+void dma_set_priority(dma_dev *dev, dma_tube tube, dma_priority priority);
+dma_tube_reg_map *dma_channel_regs(dma_dev *dev, dma_tube tube);
+void dma_attach_interrupt(dma_dev *dev, dma_tube tube, void (*handler)(void));
+void dma_detach_interrupt(dma_dev *dev, dma_tube tube);
+void dma_set_mem_addr(dma_dev *dev, dma_tube tube, const volatile void *addr);
+void dma_set_num_transfers(dma_dev *dev, dma_tube tube, uint16_t num_transfers);
+void dma_enable(dma_dev *dev, dma_tube tube);
+void dma_disable(dma_dev *dev, dma_tube tube);
+uint8_t dma_get_isr_bits(dma_dev *dev, dma_tube tube);
+void dma_clear_isr_bits(dma_dev *dev, dma_tube tube);
+
+#endif // _LIBMAPLE_DMA_H_
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _LIBMAPLE_GPIO_H_
+#define _LIBMAPLE_GPIO_H_
+
+/*
+ * host replacement for libmaple/gpio.h, used by the WIZnet simulator,
+ * pins are routed to the simulated chip select and interrupt lines
+ */
+
+#include <stdint.h>
+
+typedef struct gpio_dev gpio_dev;
+
+void gpio_write_bit(gpio_dev *dev, uint8_t bit, uint8_t val);
+uint32_t gpio_read_bit(gpio_dev *dev, uint8_t bit);
+
+#endif // _LIBMAPLE_GPIO_H_
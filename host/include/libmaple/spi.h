@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _LIBMAPLE_SPI_H_
+#define _LIBMAPLE_SPI_H_
+
+/*
+ * host replacement for libmaple/spi.h, used by the WIZnet simulator,
+ * the status register reads back as idle, unless the simulator injects an overrun
+ */
+
+#include <stdint.h>
+
+typedef struct spi_dev spi_dev;
+
+typedef struct spi_reg_map {
+	volatile uint32_t CR1;
+	volatile uint32_t CR2;
+	volatile uint32_t SR;
+	volatile uint32_t DR;
+} spi_reg_map;
+
+#define SPI_CR1_MSTR					(1U << 2)
+#define SPI_CR1_BR						(0x7 << 3)
+#define SPI_CR1_SPE					(1U << 6)
+#define SPI_CR1_BR_PCLK_DIV_2		(0x0 << 3)
+#define SPI_CR1_BR_PCLK_DIV_4		(0x1 << 3)
+#define SPI_CR1_BR_PCLK_DIV_8		(0x2 << 3)
+#define SPI_CR1_BR_PCLK_DIV_16	(0x3 << 3)
+#define SPI_CR1_BR_PCLK_DIV_32	(0x4 << 3)
+#define SPI_CR1_BR_PCLK_DIV_64	(0x5 << 3)
+#define SPI_CR1_BR_PCLK_DIV_128	(0x6 << 3)
+#define SPI_CR1_BR_PCLK_DIV_256	(0x7 << 3)
+
+#define SPI_SR_RXNE		(1U << 0)
+#define SPI_SR_MODF		(1U << 5)
+#define SPI_SR_OVR		(1U << 6)
+#define SPI_SR_BSY		(1U << 7)
+#define SPI_SR_FRLVL	(0x3 << 9)
+#define SPI_SR_FTLVL	(0x3 << 11)
+
+extern spi_dev *const SPI1;
+extern spi_reg_map wizsim_spi_regs;
+#define SPI1_BASE (&wizsim_spi_regs)
+
+void spi_rx_dma_enable(spi_dev *dev);
+void spi_rx_dma_disable(spi_dev *dev);
+void spi_tx_dma_enable(spi_dev *dev);
+void spi_tx_dma_disable(spi_dev *dev);
+uint16_t spi_rx_reg(spi_dev *dev);
+
+#endif // _LIBMAPLE_SPI_H_
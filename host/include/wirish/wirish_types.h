@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _WIRISH_WIRISH_TYPES_H_
+#define _WIRISH_WIRISH_TYPES_H_
+
+/*
+ * host replacement for wirish/wirish_types.h, used by the WIZnet simulator
+ */
+
+#include <stdint.h>
+
+#include <libmaple/gpio.h>
+
+typedef struct stm32_pin_info {
+	gpio_dev *gpio_device;
+	void *timer_device;
+	const void *adc_device;
+	uint8_t gpio_bit;
+	uint8_t timer_channel;
+	uint8_t adc_channel;
+} stm32_pin_info;
+
+#endif // _WIRISH_WIRISH_TYPES_H_
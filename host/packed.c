@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#include <string.h>
+
+#include "packed.h"
+
+int
+packed_decode(const uint8_t *blob, size_t size, Packed_Frame *frame)
+{
+	uint32_t states;
+	uint_fast8_t i;
+
+	if( (size < 20) || (blob[0] != PACKED_VERSION) )
+		return -1;
+
+	frame->version = blob[0];
+	frame->flags = blob[1];
+	frame->n = blob[2];
+	if( (frame->n > SENSOR_N) || (size < 20 + frame->n*2U) )
+		return -1;
+
+	frame->frm = packed_be32(blob + 4);
+	frame->now = ((uint64_t)packed_be32(blob + 8) << 32) | packed_be32(blob + 12);
+	states = packed_be32(blob + 16);
+	for(i=0; i<frame->n; i++)
+	{
+		frame->state[i] = (states >> (i*2)) & 0x3;
+		frame->val[i] = packed_be16(blob + 20 + i*2);
+	}
+
+	return 0;
+}
+
+void
+packed_fec_init(Packed_FEC *fec)
+{
+	memset(fec, 0, sizeof(Packed_FEC));
+	fec->group[0].first = -1;
+	fec->group[1].first = -1;
+}
+
+static Packed_FEC_Group *
+_packed_fec_group(Packed_FEC *fec, int32_t first, uint8_t n)
+{
+	Packed_FEC_Group *grp = &fec->group[(first / n) & 1];
+
+	if(grp->first != first) // recycle slot of an older group
+	{
+		grp->first = first;
+		grp->mask = 0;
+		memset(grp->acc, 0, PACKED_SIZE);
+	}
+
+	return grp;
+}
+
+void
+packed_fec_frame(Packed_FEC *fec, const uint8_t *blob)
+{
+	const uint8_t n = blob[3];
+	const int32_t frm = packed_be32(blob + 4);
+	uint_fast8_t i;
+
+	if( (n == 0) || (n > PACKED_FEC_MAX) || (frm < 0) )
+		return;
+
+	Packed_FEC_Group *grp = _packed_fec_group(fec, frm - frm % n, n);
+	grp->mask |= 1UL << (frm % n);
+	for(i=0; i<PACKED_SIZE; i++)
+		grp->acc[i] ^= blob[i];
+}
+
+int
+packed_fec_parity(Packed_FEC *fec, int32_t first, uint8_t n, const uint8_t *parity, uint8_t *blob)
+{
+	uint_fast8_t i;
+
+	if( (n == 0) || (n > PACKED_FEC_MAX) || (first < 0) || (first % n) )
+		return 0;
+
+	Packed_FEC_Group *grp = _packed_fec_group(fec, first, n);
+	const uint32_t all = n == 32 ? 0xffffffffUL : (1UL << n) - 1;
+	const uint32_t lost = ~grp->mask & all;
+
+	if( !lost || (lost & (lost - 1)) ) // none or more than one lost
+		return 0;
+
+	for(i=0; i<PACKED_SIZE; i++)
+		blob[i] = grp->acc[i] ^ parity[i];
+	grp->mask = all;
+
+	return 1;
+}
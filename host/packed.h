@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _PACKED_H_
+#define _PACKED_H_
+
+/*
+ * reference decoder of the packed engine output (/pkd ,b and /fec ,iib),
+ * see engines.h, only depends on the C library and can be copied into host
+ * applications together with packed.c
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <engines.h>
+
+typedef struct _Packed_Frame Packed_Frame;
+
+struct _Packed_Frame {
+	uint8_t version;
+	uint8_t flags;
+	uint8_t n;
+	int32_t frm;
+	uint64_t now; // NTP timetag, 32.32 fixed point
+	uint8_t state [SENSOR_N];
+	int16_t val [SENSOR_N];
+};
+
+/*
+ * FEC, two groups are tracked as the parity of a group arrives together
+ * with the first frame of the next one
+ */
+
+typedef struct _Packed_FEC_Group Packed_FEC_Group;
+typedef struct _Packed_FEC Packed_FEC;
+
+struct _Packed_FEC_Group {
+	int32_t first; // -1 := unused
+	uint32_t mask; // received frames
+	uint8_t acc [PACKED_SIZE]; // XOR of received blobs
+};
+
+struct _Packed_FEC {
+	Packed_FEC_Group group [2];
+};
+
+// returns 0 on success, -1 for unknown versions or short blobs
+int packed_decode(const uint8_t *blob, size_t size, Packed_Frame *frame);
+
+void packed_fec_init(Packed_FEC *fec);
+
+// feeds a received /pkd blob of PACKED_SIZE bytes
+void packed_fec_frame(Packed_FEC *fec, const uint8_t *blob);
+
+// feeds a received /fec parity, returns 1 and the rebuilt blob if exactly one frame was lost
+int packed_fec_parity(Packed_FEC *fec, int32_t first, uint8_t n, const uint8_t *parity, uint8_t *blob);
+
+// big-endian helpers
+static inline uint16_t
+packed_be16(const uint8_t *p)
+{
+	return ((uint16_t)p[0] << 8) | p[1];
+}
+
+static inline uint32_t
+packed_be32(const uint8_t *p)
+{
+	return ((uint32_t)packed_be16(p) << 16) | packed_be16(p + 2);
+}
+
+#endif // _PACKED_H_
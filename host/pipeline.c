@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#include <string.h>
+
+#include "pipeline.h"
+
+// globals, live in calibration.c on the device
+Calibration range;
+uint_fast8_t calibrating = 0;
+
+void
+pipeline_range_reset()
+{
+	uint_fast8_t i;
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		range.Q[i] = 0UL;
+		range.Bmin[i] = 0.f;
+		range.W[i] = 1.0 / 0xfff;
+		range.C[i][0] = 0.f; // ~ cbrt(x)
+		range.C[i][1] = 1.f; // ~ sqrt(x)
+		range.C[i][2] = 0.f; // ~ x
+	}
+
+	memset(range.X, 0, sizeof(range.X));
+	for(i=0; i<SENSOR_N; i++)
+		range.X[i][i] = CROSSTALK_ONE;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+/*
+ * replays a capture file through the sensor pipeline and an output engine
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <osc.h>
+#include <sensors.h>
+#include <calibration.h>
+#include <engines.h>
+
+#include "pipeline.h"
+#include <capture.h>
+
+#define REPLAY_BUFSIZE 0x800
+
+typedef struct _Engine Engine;
+
+struct _Engine {
+	const char *name;
+	Engine_Frame_Cb cb;
+};
+
+static const Engine engines [] = {
+	{"dump_raw", engines_dump_raw},
+	{"dump_val", engines_dump_val},
+	{"lossless", engines_lossless},
+	{"lossy", engines_lossy},
+	{"midi", engines_midi},
+	{"packed", engines_packed},
+	{"fingering", engines_fingering},
+	{NULL, NULL}
+};
+
+static int16_t frame [SENSOR_N];
+static const Breath_Config breath_config = BREATH_CONFIG_DEFAULT;
+static const Autozero_Config autozero_config = AUTOZERO_CONFIG_DEFAULT;
+static const MIDI_Config midi_config = MIDI_CONFIG_DEFAULT;
+static const Fingering_Config fingering_config = FINGERING_CONFIG_DEFAULT;
+
+static void
+_dump_text(FILE *out, int32_t frm, OSC_Timetag now)
+{
+	uint_fast8_t i;
+
+	fprintf(out, "%i %u.%06u", frm, (uint32_t)(now >> 32), (uint32_t)(((now & 0xffffffffULL) * 1000000ULL) >> 32));
+	for(i=0; i<SENSOR_N; i++)
+		fprintf(out, " %i:%f:%i", adc_raw[i], adc_val1[i], adc_state[i]);
+	fprintf(out, "\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	const Engine *engine = NULL;
+	FILE *out = stdout;
+	uint_fast8_t divider = 1;
+	uint_fast8_t fec = 0;
+	uint_fast8_t valve_cnt = 0;
+	int c;
+
+	while((c = getopt(argc, argv, "e:o:d:f:")) != -1)
+		switch(c)
+		{
+			case 'e':
+				for(engine=engines; engine->name; engine++)
+					if(!strcmp(engine->name, optarg))
+						break;
+				if(!engine->name)
+				{
+					fprintf(stderr, "unknown engine: %s\n", optarg);
+					return -1;
+				}
+				break;
+			case 'd':
+				divider = atoi(optarg);
+				break;
+			case 'f':
+				fec = atoi(optarg);
+				break;
+			case 'o':
+				out = fopen(optarg, "wb");
+				if(!out)
+				{
+					perror("fopen");
+					return -1;
+				}
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-e dump_raw|dump_val|lossless|lossy|midi|packed|fingering] [-d valve divider] [-f packed FEC group] [-o file] file\n", argv[0]);
+				return -1;
+		}
+	if(optind >= argc)
+	{
+		fprintf(stderr, "usage: %s [-e dump_raw|dump_val|lossless|lossy|midi|packed|fingering] [-d valve divider] [-f packed FEC group] [-o file] file\n", argv[0]);
+		return -1;
+	}
+
+	FILE *f = fopen(argv[optind], "rb");
+	if(!f)
+	{
+		perror("fopen");
+		return -1;
+	}
+
+	pipeline_range_reset();
+	adc_raw = frame;
+	breath_configure(&breath_config, BREATH_RATE_DEFAULT);
+	autozero_configure(&autozero_config, BREATH_RATE_DEFAULT);
+	midi_configure(&midi_config);
+	fingering_configure(&fingering_config);
+	packed_configure(0, fec);
+
+	osc_data_t buf [REPLAY_BUFSIZE] __attribute__((aligned(4)));
+	osc_data_t out_buf [REPLAY_BUFSIZE] __attribute__((aligned(4)));
+	uint32_t frames = 0;
+	uint32_t size;
+	while(fread(&size, sizeof(uint32_t), 1, f) == 1)
+	{
+		size = ntohl(size);
+		if( (size > REPLAY_BUFSIZE) || (fread(buf, size, 1, f) != 1) )
+		{
+			fprintf(stderr, "truncated capture file\n");
+			break;
+		}
+
+		osc_data_t *buf_ptr = buf;
+		const char *path;
+		const char *fmt;
+		OSC_Blob b;
+
+		buf_ptr = osc_get_path(buf_ptr, &path);
+		buf_ptr = osc_get_fmt(buf_ptr, &fmt);
+
+		if(!strcmp(path, "/capture/range") && !strcmp(fmt, ",b"))
+		{
+			buf_ptr = osc_get_blob(buf_ptr, &b);
+			if(b.size != sizeof(Calibration))
+			{
+				fprintf(stderr, "calibration size mismatch\n");
+				break;
+			}
+			memcpy(&range, b.payload, sizeof(Calibration));
+		}
+		else if(!strcmp(path, "/capture/frames") && !strcmp(fmt, ",ib"))
+		{
+			int32_t n;
+			buf_ptr = osc_get_int32(buf_ptr, &n);
+			buf_ptr = osc_get_blob(buf_ptr, &b);
+			if(n != SENSOR_N)
+			{
+				fprintf(stderr, "sensor number mismatch\n");
+				break;
+			}
+
+			osc_data_t *rec;
+			for(rec=b.payload; rec<b.payload+b.size; rec+=CAPTURE_RECORD_SIZE)
+			{
+				osc_data_t *rec_ptr = rec;
+				int32_t frm;
+				OSC_Timetag now;
+				OSC_Timetag offset;
+				uint_fast8_t i;
+
+				rec_ptr = osc_get_int32(rec_ptr, &frm);
+				rec_ptr = osc_get_timetag(rec_ptr, &now);
+				rec_ptr = osc_get_timetag(rec_ptr, &offset);
+				for(i=0; i<SENSOR_N; i++, rec_ptr+=2)
+					adc_raw[i] = ref_ntoh(rec_ptr);
+
+				uint_fast8_t groups = SENSORS_GROUP_BREATH;
+				if(++valve_cnt >= divider)
+				{
+					groups |= SENSORS_GROUP_VALVES;
+					valve_cnt = 0;
+				}
+				sensors_update(groups);
+				frames++;
+
+				if(engine)
+				{
+					osc_data_t *out_ptr = engine->cb(out_buf, frm, now, offset);
+					uint32_t len = htonl(out_ptr - out_buf);
+					fwrite(&len, sizeof(uint32_t), 1, out);
+					fwrite(out_buf, out_ptr - out_buf, 1, out);
+				}
+				else
+					_dump_text(out, frm, now);
+			}
+		}
+	}
+
+	fprintf(stderr, "%u frames replayed\n", frames);
+
+	fclose(f);
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
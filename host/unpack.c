@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+/*
+ * reads size-prefixed OSC packets as written by replay -o and prints one
+ * line per frame of the packed engine, decoding is done by packed.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "packed.h"
+
+#define UNPACK_BUFSIZE 0x800
+
+static void
+_print_frame(const uint8_t *blob, size_t size, const char *note)
+{
+	static const char state_chr [4] = {'.', '+', '-', '*'}; // idle, on, off, set
+	Packed_Frame frame;
+	uint_fast8_t i;
+
+	if(packed_decode(blob, size, &frame))
+		return;
+
+	printf("%i %.6f", frame.frm, (double)frame.now / 0x100000000ULL);
+	for(i=0; i<frame.n; i++)
+	{
+		if(frame.flags & PACKED_FLAG_Q15)
+			printf(" %c%.4f", state_chr[frame.state[i]], frame.val[i] / (double)0x7fff);
+		else
+			printf(" %c%i", state_chr[frame.state[i]], frame.val[i]);
+	}
+	printf("%s\n", note);
+}
+
+static uint32_t frames = 0;
+static uint32_t recovered = 0;
+static Packed_FEC fec;
+
+// handles a single OSC message, /pkd or /fec
+static void
+_message(const uint8_t *msg, size_t len)
+{
+	size_t size;
+
+	if( (len >= 16) && !memcmp(msg, "/pkd\0\0\0\0,b\0\0", 12) )
+	{
+		size = packed_be32(msg + 12);
+		if( (size > len - 16) || (size < PACKED_SIZE) )
+			return;
+
+		packed_fec_frame(&fec, msg + 16);
+		_print_frame(msg + 16, size, "");
+		frames++;
+	}
+	else if( (len >= 24) && !memcmp(msg, "/fec\0\0\0\0,iib\0\0\0\0", 16) )
+	{
+		int32_t first = packed_be32(msg + 16);
+		uint8_t n = packed_be32(msg + 20);
+		uint8_t blob [PACKED_SIZE];
+
+		size = packed_be32(msg + 24);
+		if( (size > len - 28) || (size < PACKED_SIZE) )
+			return;
+
+		if(packed_fec_parity(&fec, first, n, msg + 28, blob))
+		{
+			_print_frame(blob, PACKED_SIZE, " (recovered)");
+			recovered++;
+		}
+	}
+}
+
+// handles a packet, either a single message or a bundle of them
+static void
+_packet(const uint8_t *buf, size_t len)
+{
+	const uint8_t *ptr;
+
+	if( (len < 16) || memcmp(buf, "#bundle", 8) )
+	{
+		_message(buf, len);
+		return;
+	}
+
+	for(ptr=buf+16; ptr+4<=buf+len; )
+	{
+		uint32_t size = packed_be32(ptr);
+		ptr += 4;
+		if(size > (size_t)(buf + len - ptr))
+			break;
+		_packet(ptr, size);
+		ptr += size;
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	FILE *f = stdin;
+	uint32_t drop = 0;
+	uint32_t packets = 0;
+	int c;
+
+	while((c = getopt(argc, argv, "l:")) != -1)
+		switch(c)
+		{
+			case 'l':
+				drop = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-l drop every n-th packet] [file]\n", argv[0]);
+				return -1;
+		}
+
+	if( (optind < argc) && !(f = fopen(argv[optind], "rb")) )
+	{
+		perror("fopen");
+		return -1;
+	}
+
+	packed_fec_init(&fec);
+
+	uint8_t buf [UNPACK_BUFSIZE];
+	uint8_t len_be [4];
+	while(fread(len_be, 4, 1, f) == 1)
+	{
+		uint32_t len = packed_be32(len_be);
+		if( (len > UNPACK_BUFSIZE) || (fread(buf, len, 1, f) != 1) )
+		{
+			fprintf(stderr, "truncated file\n");
+			break;
+		}
+
+		if(drop && (++packets % drop == 0) ) // simulated packet loss
+			continue;
+
+		_packet(buf, len);
+	}
+
+	fprintf(stderr, "%u frames decoded, %u recovered\n", frames, recovered);
+
+	if(f != stdin)
+		fclose(f);
+
+	return 0;
+}
@@ -0,0 +1,1054 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+/*
+ * register level simulator of the W5500, runs the unmodified WIZnet driver
+ * (wiz/wiz.c, wiz/W5500.c) on the host on top of shims of the libmaple SPI,
+ * DMA and GPIO calls, simulated sockets are bridged to loopback UDP/TCP
+ * sockets of the host, SPI bytes and transactions are counted per scenario,
+ * time advances with the bytes clocked at the current SPI prescaler
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <oscpod.h>
+#include <tube.h>
+#include <sntp.h>
+
+#include <libmaple/dma.h>
+#include <libmaple/spi.h>
+
+#include "../wiz/W5500_private.h"
+
+#define SIM_MEM_SIZE 0x4000 // max. TX/RX buffer of a single socket
+#define SIM_PORT 53300 // port of the simulated socket under test
+#define SIM_FRAMES 1000
+#define SIM_SIZE 256
+#define SIM_BURST 8 // datagrams queued on the chip before each udp_dispatch
+#define SIM_SEND_DELAY 2 // chip selects a SEND takes at least, SEND_OK never shows up in the frame after the command
+
+typedef struct _Sim_Socket Sim_Socket;
+typedef struct _Sim_Tube Sim_Tube;
+typedef struct _Sim_Stats Sim_Stats;
+
+struct _Sim_Socket {
+	uint8_t reg [0x40];
+	uint8_t tx [SIM_MEM_SIZE];
+	uint8_t rx [SIM_MEM_SIZE];
+	int fd; // bridged host socket, -1 := none
+	uint8_t sending; // chip selects until SEND_OK, 0 := idle
+};
+
+struct _Sim_Tube {
+	dma_tube_reg_map regs;
+	const volatile void *mem;
+	uint16_t num;
+	uint8_t enabled;
+	uint8_t isr;
+	void (*handler)(void);
+};
+
+struct _Sim_Stats {
+	uint64_t bytes; // clocked over SPI
+	uint64_t frames; // chip selects
+	uint64_t xfers; // DMA transfers
+};
+
+struct gpio_dev {
+	uint8_t port;
+};
+
+struct dma_dev {
+	uint8_t num;
+};
+
+struct spi_dev {
+	uint8_t rx_dma;
+	uint8_t tx_dma;
+};
+
+static uint64_t sim_cycles; // core clock, SPI1 runs at the same peripheral clock
+static uint32_t sim_err_rate; // every n-th read transfer overruns, 0 := never
+static uint32_t sim_err_cnt;
+
+static uint8_t sim_reg [0x40]; // common registers
+static Sim_Socket sim_sock [WIZ_MAX_SOCK_NUM];
+static Sim_Stats sim_stats;
+
+// SPI frame in flight
+static uint8_t sim_hdr [WIZ_SEND_OFFSET];
+static uint_fast8_t sim_hdr_n;
+static uint16_t sim_addr;
+
+static struct gpio_dev gpio_a = {.port = 'A'};
+static struct gpio_dev gpio_b = {.port = 'B'};
+static struct dma_dev dma1 = {.num = 1};
+static struct spi_dev spi1;
+static Sim_Tube sim_tube [DMA_CH7 + 1];
+
+dma_dev *const DMA1 = &dma1;
+spi_dev *const SPI1 = &spi1;
+spi_reg_map wizsim_spi_regs; // SR reads as idle, no FIFO levels, no errors
+
+const stm32_pin_info PIN_MAP [BOARD_NR_GPIO_PINS] = {
+	[BOARD_SPI3_NSS_PIN]	= {.gpio_device = &gpio_a, .gpio_bit = 15},
+	[PA14]								= {.gpio_device = &gpio_a, .gpio_bit = 14},
+	[PA8]									= {.gpio_device = &gpio_a, .gpio_bit = 8},
+	[PB2]									= {.gpio_device = &gpio_b, .gpio_bit = 2}
+};
+
+dma_tube_config spi_rx_tube;
+dma_tube_config spi_tx_tube;
+
+uint_fast8_t buf_o_ptr = 0;
+const uint_fast8_t buf_i_ptr = 0;
+uint8_t buf_o[2] [CHIMAERA_BUFSIZE] __attribute__((aligned(4)));
+uint8_t buf_i[1] [CHIMAERA_BUFSIZE] __attribute__((aligned(4)));
+
+uint32_t
+sntp_uptime_cycles(uint32_t *cycles)
+{
+	*cycles = sim_cycles % SNTP_SYSTICK_CYCLES;
+	return sim_cycles / SNTP_SYSTICK_CYCLES;
+}
+
+// only needed by tcp_dispatch in SLIP mode, which is not simulated
+size_t
+slip_decode(uint8_t *buf, size_t len, size_t *size)
+{
+	*size = 0;
+	return 0;
+}
+
+/*
+ * chip model
+ */
+
+static inline uint16_t
+_get16(const uint8_t *reg)
+{
+	return (reg[0] << 8) | reg[1];
+}
+
+static inline void
+_set16(uint8_t *reg, uint16_t val)
+{
+	reg[0] = val >> 8;
+	reg[1] = val & 0xff;
+}
+
+static inline uint16_t
+_sim_tx_size(Sim_Socket *s)
+{
+	return s->reg[WIZ_Sn_TXBUF_SIZE] * 0x0400;
+}
+
+static inline uint16_t
+_sim_rx_size(Sim_Socket *s)
+{
+	return s->reg[WIZ_Sn_RXBUF_SIZE] * 0x0400;
+}
+
+static inline uint16_t
+_sim_rx_rsr(Sim_Socket *s)
+{
+	return _get16(&s->reg[WIZ_Sn_RX_WR]) - _get16(&s->reg[WIZ_Sn_RX_RD]);
+}
+
+static inline uint16_t
+_sim_tx_fsr(Sim_Socket *s)
+{
+	return _sim_tx_size(s) - (uint16_t)(_get16(&s->reg[WIZ_Sn_TX_WR]) - _get16(&s->reg[WIZ_Sn_TX_RD]));
+}
+
+static void
+_sim_unbridge(Sim_Socket *s)
+{
+	if(s->fd >= 0)
+		close(s->fd);
+	s->fd = -1;
+	s->sending = 0; // lost with the socket
+}
+
+static void
+_sim_reset()
+{
+	uint_fast8_t i;
+
+	memset(sim_reg, 0, sizeof(sim_reg));
+	sim_reg[WIZ_RTR] = 0x07;
+	sim_reg[WIZ_RTR+1] = 0xd0;
+	sim_reg[WIZ_RCR] = 0x08;
+	sim_reg[WIZ_PHYCFGR] = WIZ_PHYCFGR_RST | WIZ_PHYCFGR_OPMD_HW | WIZ_PHYCFGR_OPMDC
+		| WIZ_PHYCFGR_DPX | WIZ_PHYCFGR_SPD | WIZ_PHYCFGR_LNK;
+	sim_reg[WIZ_VERSIONR] = 0x04;
+
+	for(i=0; i<WIZ_MAX_SOCK_NUM; i++)
+	{
+		Sim_Socket *s = &sim_sock[i];
+
+		_sim_unbridge(s);
+		memset(s->reg, 0, sizeof(s->reg));
+		s->reg[WIZ_Sn_TTL] = 0x80;
+		s->reg[WIZ_Sn_MSSR] = 0xff;
+		s->reg[WIZ_Sn_MSSR+1] = 0xff;
+		s->reg[WIZ_Sn_RXBUF_SIZE] = 2;
+		s->reg[WIZ_Sn_TXBUF_SIZE] = 2;
+		s->reg[WIZ_Sn_IMR] = 0xff;
+	}
+}
+
+static int
+_sim_bind(Sim_Socket *s, int type)
+{
+	struct sockaddr_in addr;
+	int one = 1;
+
+	s->fd = socket(AF_INET, type, 0);
+	if(s->fd < 0)
+		return -1;
+	setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	fcntl(s->fd, F_SETFL, O_NONBLOCK);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(_get16(&s->reg[WIZ_Sn_PORT]));
+	if(bind(s->fd, (struct sockaddr *)&addr, sizeof(addr)))
+	{
+		perror("wizsim: bind");
+		_sim_unbridge(s);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void
+_sim_remote(Sim_Socket *s, struct sockaddr_in *addr)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	memcpy(&addr->sin_addr.s_addr, &s->reg[WIZ_Sn_DIPR], 4);
+	addr->sin_port = htons(_get16(&s->reg[WIZ_Sn_DPORT]));
+}
+
+static void
+_sim_send_done(Sim_Socket *s)
+{
+	s->sending = 0;
+	s->reg[WIZ_Sn_TX_RD] = s->reg[WIZ_Sn_TX_WR];
+	s->reg[WIZ_Sn_TX_RD+1] = s->reg[WIZ_Sn_TX_WR+1];
+	s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_SEND_OK;
+}
+
+static void
+_sim_send(Sim_Socket *s)
+{
+	static uint8_t dat [SIM_MEM_SIZE];
+	struct sockaddr_in addr;
+
+	if(s->sending) // the driver never does this, but the chip would finish first
+		_sim_send_done(s);
+
+	uint16_t rd = _get16(&s->reg[WIZ_Sn_TX_RD]);
+	uint16_t wr = _get16(&s->reg[WIZ_Sn_TX_WR]);
+	uint16_t mask = _sim_tx_size(s) - 1;
+	uint16_t len = wr - rd;
+	uint16_t i;
+
+	// everything between Sn_TX_RD and Sn_TX_WR goes out as one datagram
+	for(i=0; i<len; i++)
+		dat[i] = s->tx[(rd + i) & mask];
+
+	if(s->fd >= 0)
+	{
+		if(s->reg[WIZ_Sn_SR] == WIZ_Sn_SR_UDP)
+		{
+			_sim_remote(s, &addr);
+			sendto(s->fd, dat, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+		}
+		else if(s->reg[WIZ_Sn_SR] == WIZ_Sn_SR_ESTABLISHED)
+			send(s->fd, dat, len, 0);
+	}
+
+	s->sending = SIM_SEND_DELAY;
+}
+
+static void
+_sim_command(Sim_Socket *s, uint8_t cmd)
+{
+	struct sockaddr_in addr;
+
+	switch(cmd)
+	{
+		case WIZ_Sn_CR_OPEN:
+			_sim_unbridge(s);
+			_set16(&s->reg[WIZ_Sn_TX_RD], 0);
+			_set16(&s->reg[WIZ_Sn_TX_WR], 0);
+			_set16(&s->reg[WIZ_Sn_RX_RD], 0);
+			_set16(&s->reg[WIZ_Sn_RX_WR], 0);
+			switch(s->reg[WIZ_Sn_MR] & 0x0f)
+			{
+				case WIZ_Sn_MR_UDP:
+					s->reg[WIZ_Sn_SR] = _sim_bind(s, SOCK_DGRAM) ? WIZ_Sn_SR_CLOSED : WIZ_Sn_SR_UDP;
+					break;
+				case WIZ_Sn_MR_TCP:
+					s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_INIT;
+					break;
+				case WIZ_Sn_MR_MACRAW: // not bridged, never receives anything
+					s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_MACRAW;
+					break;
+			}
+			break;
+
+		case WIZ_Sn_CR_LISTEN:
+			if( (s->reg[WIZ_Sn_SR] == WIZ_Sn_SR_INIT) && !_sim_bind(s, SOCK_STREAM) && !listen(s->fd, 1) )
+				s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_LISTEN;
+			break;
+
+		case WIZ_Sn_CR_CONNECT:
+			if(s->reg[WIZ_Sn_SR] != WIZ_Sn_SR_INIT)
+				break;
+			s->fd = socket(AF_INET, SOCK_STREAM, 0);
+			_sim_remote(s, &addr);
+			if( (s->fd >= 0) && !connect(s->fd, (struct sockaddr *)&addr, sizeof(addr)) )
+			{
+				fcntl(s->fd, F_SETFL, O_NONBLOCK);
+				s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_ESTABLISHED;
+				s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_CON;
+			}
+			else
+			{
+				_sim_unbridge(s);
+				s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_CLOSED;
+				s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_TIMEOUT;
+			}
+			break;
+
+		case WIZ_Sn_CR_DISCON:
+			if( (s->reg[WIZ_Sn_SR] == WIZ_Sn_SR_ESTABLISHED) || (s->reg[WIZ_Sn_SR] == WIZ_Sn_SR_CLOSE_WAIT) )
+				s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_DISCON;
+			// fall-through
+		case WIZ_Sn_CR_CLOSE:
+			_sim_unbridge(s);
+			s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_CLOSED;
+			break;
+
+		case WIZ_Sn_CR_SEND:
+			_sim_send(s);
+			break;
+
+		case WIZ_Sn_CR_RECV:
+			if(_sim_rx_rsr(s)) // there is more
+				s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_RECV;
+			break;
+	}
+}
+
+static void
+_sim_rx_put(Sim_Socket *s, const uint8_t *dat, uint16_t len)
+{
+	uint16_t wr = _get16(&s->reg[WIZ_Sn_RX_WR]);
+	uint16_t mask = _sim_rx_size(s) - 1;
+	uint16_t i;
+
+	for(i=0; i<len; i++)
+		s->rx[(wr + i) & mask] = dat[i];
+	_set16(&s->reg[WIZ_Sn_RX_WR], wr + len);
+	s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_RECV;
+}
+
+static void
+_sim_poll_socket(Sim_Socket *s)
+{
+	static uint8_t dat [SIM_MEM_SIZE];
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	uint16_t space;
+	ssize_t len;
+	int fd;
+
+	if(s->fd < 0)
+		return;
+
+	switch(s->reg[WIZ_Sn_SR])
+	{
+		case WIZ_Sn_SR_UDP:
+			for(;;)
+			{
+				space = _sim_rx_size(s) - _sim_rx_rsr(s);
+				if(space <= WIZ_UDP_HDR_SIZE)
+					break;
+
+				// leave datagrams in the host queue until they fit, including their header
+				len = recv(s->fd, dat, sizeof(dat), MSG_PEEK | MSG_TRUNC);
+				if( (len < 0) || (len + WIZ_UDP_HDR_SIZE > space) )
+					break;
+
+				addr_len = sizeof(addr);
+				len = recvfrom(s->fd, dat + WIZ_UDP_HDR_SIZE, sizeof(dat) - WIZ_UDP_HDR_SIZE, 0,
+					(struct sockaddr *)&addr, &addr_len);
+				memcpy(dat, &addr.sin_addr.s_addr, 4);
+				_set16(&dat[4], ntohs(addr.sin_port));
+				_set16(&dat[6], len);
+				_sim_rx_put(s, dat, len + WIZ_UDP_HDR_SIZE);
+			}
+			break;
+
+		case WIZ_Sn_SR_LISTEN:
+			addr_len = sizeof(addr);
+			fd = accept(s->fd, (struct sockaddr *)&addr, &addr_len);
+			if(fd < 0)
+				break;
+			fcntl(fd, F_SETFL, O_NONBLOCK);
+			close(s->fd);
+			s->fd = fd;
+			memcpy(&s->reg[WIZ_Sn_DIPR], &addr.sin_addr.s_addr, 4);
+			_set16(&s->reg[WIZ_Sn_DPORT], ntohs(addr.sin_port));
+			s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_ESTABLISHED;
+			s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_CON;
+			break;
+
+		case WIZ_Sn_SR_ESTABLISHED:
+			space = _sim_rx_size(s) - _sim_rx_rsr(s);
+			if(space == 0)
+				break;
+			len = recv(s->fd, dat, space, 0);
+			if(len > 0)
+				_sim_rx_put(s, dat, len);
+			else if(len == 0) // peer has closed
+			{
+				s->reg[WIZ_Sn_SR] = WIZ_Sn_SR_CLOSE_WAIT;
+				s->reg[WIZ_Sn_IR] |= WIZ_Sn_IR_DISCON;
+			}
+			break;
+	}
+}
+
+static void
+_sim_poll(uint_fast8_t wait)
+{
+	uint_fast8_t i;
+
+	for(i=0; i<WIZ_MAX_SOCK_NUM; i++)
+	{
+		Sim_Socket *s = &sim_sock[i];
+
+		// an IRQ wait lasts long enough for any SEND to complete
+		if(s->sending && (wait || !--s->sending) )
+			_sim_send_done(s);
+		_sim_poll_socket(s);
+	}
+}
+
+static uint8_t
+_sim_sir()
+{
+	uint8_t sir = 0;
+	uint_fast8_t i;
+
+	for(i=0; i<WIZ_MAX_SOCK_NUM; i++)
+		if(sim_sock[i].reg[WIZ_Sn_IR] & sim_sock[i].reg[WIZ_Sn_IMR])
+			sir |= 1U << i;
+
+	return sir;
+}
+
+static uint_fast8_t
+_sim_int()
+{
+	return (sim_reg[WIZ_IR] & sim_reg[WIZ_IMR]) || (_sim_sir() & sim_reg[WIZ_SIMR]);
+}
+
+static uint8_t
+_sim_read(uint8_t bsb, uint16_t addr)
+{
+	if(bsb == 0) // common registers
+	{
+		if(addr == WIZ_SIR)
+			return _sim_sir();
+		return addr < sizeof(sim_reg) ? sim_reg[addr] : 0;
+	}
+
+	Sim_Socket *s = &sim_sock[(bsb - 1) / 4];
+	switch( (bsb - 1) % 4)
+	{
+		case 0: // socket registers
+			switch(addr)
+			{
+				case WIZ_Sn_TX_FSR:
+					return _sim_tx_fsr(s) >> 8;
+				case WIZ_Sn_TX_FSR+1:
+					return _sim_tx_fsr(s) & 0xff;
+				case WIZ_Sn_RX_RSR:
+					return _sim_rx_rsr(s) >> 8;
+				case WIZ_Sn_RX_RSR+1:
+					return _sim_rx_rsr(s) & 0xff;
+			}
+			return addr < sizeof(s->reg) ? s->reg[addr] : 0;
+		case 1: // TX buffer
+			return _sim_tx_size(s) ? s->tx[addr & (_sim_tx_size(s) - 1)] : 0;
+		case 2: // RX buffer
+			return _sim_rx_size(s) ? s->rx[addr & (_sim_rx_size(s) - 1)] : 0;
+	}
+
+	return 0;
+}
+
+static void
+_sim_write(uint8_t bsb, uint16_t addr, uint8_t val)
+{
+	if(bsb == 0) // common registers
+	{
+		switch(addr)
+		{
+			case WIZ_MR:
+				if(val & WIZ_MR_RST)
+					_sim_reset(); // done at once, MR reads back as 0
+				else
+					sim_reg[addr] = val;
+				break;
+			case WIZ_IR:
+				sim_reg[addr] &= ~val;
+				break;
+			case WIZ_SIR:
+			case WIZ_UIPR:
+			case WIZ_UIPR+1:
+			case WIZ_UIPR+2:
+			case WIZ_UIPR+3:
+			case WIZ_UPORTR:
+			case WIZ_UPORTR+1:
+			case WIZ_VERSIONR:
+				break; // read-only
+			default:
+				if(addr < sizeof(sim_reg))
+					sim_reg[addr] = val;
+				break;
+		}
+		return;
+	}
+
+	Sim_Socket *s = &sim_sock[(bsb - 1) / 4];
+	switch( (bsb - 1) % 4)
+	{
+		case 0: // socket registers
+			switch(addr)
+			{
+				case WIZ_Sn_CR:
+					_sim_command(s, val); // done at once, Sn_CR reads back as 0
+					break;
+				case WIZ_Sn_IR:
+					s->reg[addr] &= ~val;
+					break;
+				case WIZ_Sn_SR:
+				case WIZ_Sn_TX_FSR:
+				case WIZ_Sn_TX_FSR+1:
+				case WIZ_Sn_TX_RD:
+				case WIZ_Sn_TX_RD+1:
+				case WIZ_Sn_RX_RSR:
+				case WIZ_Sn_RX_RSR+1:
+				case WIZ_Sn_RX_WR:
+				case WIZ_Sn_RX_WR+1:
+					break; // read-only
+				default:
+					if(addr < sizeof(s->reg))
+						s->reg[addr] = val;
+					break;
+			}
+			break;
+		case 1: // TX buffer
+			if(_sim_tx_size(s))
+				s->tx[addr & (_sim_tx_size(s) - 1)] = val;
+			break;
+		case 2: // RX buffer
+			if(_sim_rx_size(s))
+				s->rx[addr & (_sim_rx_size(s) - 1)] = val;
+			break;
+	}
+}
+
+static uint8_t
+_sim_spi_byte(uint8_t mosi)
+{
+	sim_stats.bytes++;
+	sim_cycles += 8 * (2U << ( (wizsim_spi_regs.CR1 & SPI_CR1_BR) >> 3) );
+
+	// address and control phase
+	if(sim_hdr_n < WIZ_SEND_OFFSET)
+	{
+		sim_hdr[sim_hdr_n++] = mosi;
+		if(sim_hdr_n == WIZ_SEND_OFFSET)
+			sim_addr = (sim_hdr[0] << 8) | sim_hdr[1];
+		return sim_hdr_n; // the W5500 shifts out 0x01, 0x02, 0x03
+	}
+
+	// data phase, variable length, the address increments after each byte
+	const uint8_t bsb = sim_hdr[2] >> W5500_CNTRL_PHASE_BLOCK_SEL_SHIFT;
+	if(sim_hdr[2] & W5500_CNTRL_PHASE_WRITE)
+	{
+		_sim_write(bsb, sim_addr++, mosi);
+		return 0x00;
+	}
+	return _sim_read(bsb, sim_addr++);
+}
+
+/*
+ * libmaple shims
+ */
+
+void
+gpio_write_bit(gpio_dev *dev, uint8_t bit, uint8_t val)
+{
+	const stm32_pin_info *ss = &PIN_MAP[UDP_SS];
+
+	if( (dev == ss->gpio_device) && (bit == ss->gpio_bit) && !val) // chip select falling edge
+	{
+		sim_stats.frames++;
+		sim_hdr_n = 0;
+		_sim_poll(0);
+	}
+}
+
+uint32_t
+gpio_read_bit(gpio_dev *dev, uint8_t bit)
+{
+	const stm32_pin_info *irq = &PIN_MAP[UDP_INT];
+
+	if( (dev == irq->gpio_device) && (bit == irq->gpio_bit) )
+	{
+		_sim_poll(1);
+		return _sim_int() ? 0 : 1; // active low
+	}
+
+	return 1;
+}
+
+static void
+_sim_dma_run()
+{
+	Sim_Tube *tx = &sim_tube[WIZ_SPI_TX_DMA_TUB];
+	Sim_Tube *rx = &sim_tube[WIZ_SPI_RX_DMA_TUB];
+	const uint8_t *src = (const uint8_t *)tx->mem;
+	uint8_t *dst = (uint8_t *)rx->mem;
+	const uint_fast8_t minc = tx->regs.CCR & DMA_CCR_MINC;
+	const uint_fast8_t duplex = spi1.rx_dma && rx->enabled;
+	uint16_t i;
+
+	sim_stats.xfers++;
+
+	// the TX tube clocks the bus, the RX tube samples it when enabled
+	for(i=0; i<tx->num; i++)
+	{
+		uint8_t miso = _sim_spi_byte(src[minc ? i : 0]);
+		if(duplex && (i < rx->num) )
+			dst[i] = miso;
+	}
+
+	tx->isr = DMA_ISR_TCIF;
+	if(duplex)
+	{
+		rx->isr = DMA_ISR_TCIF;
+
+		// only reads are hit, the driver retries them without side effects on the chip
+		if(sim_err_rate && (++sim_err_cnt == sim_err_rate) )
+		{
+			sim_err_cnt = 0;
+			wizsim_spi_regs.SR |= SPI_SR_OVR;
+		}
+	}
+
+	// transfer complete IRQ, the driver has only one of both attached
+	if(duplex && rx->handler)
+		rx->handler();
+	else if(tx->handler)
+		tx->handler();
+}
+
+int
+dma_tube_cfg(dma_dev *dev, dma_tube tube, dma_tube_config *cfg)
+{
+	sim_tube[tube].regs.CCR = DMA_CCR_MINC;
+	return DMA_TUBE_CFG_SUCCESS;
+}
+
+void
+dma_set_priority(dma_dev *dev, dma_tube tube, dma_priority priority)
+{
+	// nothing to do
+}
+
+dma_tube_reg_map *
+dma_channel_regs(dma_dev *dev, dma_tube tube)
+{
+	return &sim_tube[tube].regs;
+}
+
+void
+dma_attach_interrupt(dma_dev *dev, dma_tube tube, void (*handler)(void))
+{
+	sim_tube[tube].handler = handler;
+}
+
+void
+dma_detach_interrupt(dma_dev *dev, dma_tube tube)
+{
+	sim_tube[tube].handler = NULL;
+}
+
+void
+dma_set_mem_addr(dma_dev *dev, dma_tube tube, const volatile void *addr)
+{
+	sim_tube[tube].mem = addr;
+}
+
+void
+dma_set_num_transfers(dma_dev *dev, dma_tube tube, uint16_t num_transfers)
+{
+	sim_tube[tube].num = num_transfers;
+}
+
+void
+dma_enable(dma_dev *dev, dma_tube tube)
+{
+	sim_tube[tube].enabled = 1;
+
+	// the whole transfer and its IRQ run synchronously
+	if( (tube == WIZ_SPI_TX_DMA_TUB) && spi1.tx_dma)
+		_sim_dma_run();
+}
+
+void
+dma_disable(dma_dev *dev, dma_tube tube)
+{
+	sim_tube[tube].enabled = 0;
+}
+
+uint8_t
+dma_get_isr_bits(dma_dev *dev, dma_tube tube)
+{
+	return sim_tube[tube].isr;
+}
+
+void
+dma_clear_isr_bits(dma_dev *dev, dma_tube tube)
+{
+	sim_tube[tube].isr = 0;
+}
+
+void
+spi_rx_dma_enable(spi_dev *dev)
+{
+	dev->rx_dma = 1;
+}
+
+void
+spi_rx_dma_disable(spi_dev *dev)
+{
+	dev->rx_dma = 0;
+}
+
+void
+spi_tx_dma_enable(spi_dev *dev)
+{
+	dev->tx_dma = 1;
+}
+
+void
+spi_tx_dma_disable(spi_dev *dev)
+{
+	dev->tx_dma = 0;
+}
+
+uint16_t
+spi_rx_reg(spi_dev *dev)
+{
+	wizsim_spi_regs.SR &= ~SPI_SR_OVR; // reading DR then SR clears it
+	return 0;
+}
+
+/*
+ * scenarios
+ */
+
+typedef struct _Scenario Scenario;
+
+struct _Scenario {
+	const char *name;
+	uint8_t irq; // use SEND_OK IRQ
+	void (*run)(uint8_t sock, uint8_t *dat, uint16_t len);
+};
+
+static int sink_fd; // receives output of the simulated socket
+static int source_fd; // sends input to the simulated socket
+static uint16_t sink_port;
+static uint8_t ref [CHIMAERA_BUFSIZE]; // payload of every datagram
+static uint16_t ref_len;
+static uint32_t dispatched; // intact datagrams seen by _dispatch_cb
+
+static void
+_irq_cb(uint8_t isr)
+{
+	// nothing to do, SEND_OK is handled by the driver itself
+}
+
+static void
+_dispatch_cb(uint8_t *ip, uint16_t port, uint8_t *buf, uint16_t len)
+{
+	if( (len == ref_len) && !memcmp(buf, ref, len) )
+		dispatched++;
+}
+
+static void
+_run_send(uint8_t sock, uint8_t *dat, uint16_t len)
+{
+	memcpy(BUF_O_OFFSET(buf_o_ptr), dat, len);
+	udp_send(sock, BUF_O_BASE(buf_o_ptr), len);
+}
+
+static void
+_run_send_irq(uint8_t sock, uint8_t *dat, uint16_t len)
+{
+	memcpy(BUF_O_OFFSET(buf_o_ptr), dat, len);
+	udp_send_nonblocking(sock, BUF_O_BASE(buf_o_ptr), len);
+	buf_o_ptr ^= 1;
+}
+
+static void
+_run_sendv(uint8_t sock, uint8_t *dat, uint16_t len)
+{
+	const Wiz_Vec vec [2] = {
+		{dat, 16}, // e.g. a bundle header
+		{dat + 16, len - 16}
+	};
+
+	udp_sendv_nonblocking(sock, vec, 2);
+}
+
+static void
+_run_queue(uint8_t sock, uint8_t *dat, uint16_t len)
+{
+	memcpy(BUF_O_OFFSET(buf_o_ptr), dat, len);
+	udp_queue_nonblocking(sock, BUF_O_BASE(buf_o_ptr), len);
+	buf_o_ptr ^= 1;
+}
+
+static void
+_run_dispatch(uint8_t sock, uint8_t *dat, uint16_t len)
+{
+	static uint_fast8_t burst = 0;
+	struct sockaddr_in addr;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(SIM_PORT);
+	sendto(source_fd, dat, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+
+	if(++burst == SIM_BURST)
+	{
+		burst = 0;
+		_sim_poll(0);
+		udp_dispatch(sock, BUF_I_BASE(buf_i_ptr), _dispatch_cb);
+	}
+}
+
+static const Scenario scenarios [] = {
+	{"send", 0, _run_send},
+	{"send_irq", 1, _run_send_irq},
+	{"sendv", 1, _run_sendv},
+	{"queue", 1, _run_queue},
+	{"dispatch", 0, _run_dispatch},
+	{NULL, 0, NULL}
+};
+
+static uint32_t
+_sink_drain()
+{
+	static uint8_t dat [SIM_MEM_SIZE];
+	uint32_t n = 0;
+	ssize_t len;
+
+	// count intact datagrams
+	while( (len = recv(sink_fd, dat, sizeof(dat), MSG_DONTWAIT)) >= 0)
+		if( (len == ref_len) && !memcmp(dat, ref, len) )
+			n++;
+
+	return n;
+}
+
+static int
+_host_socket(uint16_t *port)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	int size = 0x100000;
+	int fd;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if(fd < 0)
+		return -1;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0; // any
+	if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || getsockname(fd, (struct sockaddr *)&addr, &addr_len))
+	{
+		close(fd);
+		return -1;
+	}
+	if(port)
+		*port = ntohs(addr.sin_port);
+
+	return fd;
+}
+
+static void
+_scenario(const Scenario *scn, uint8_t sock, uint32_t frames, uint16_t len)
+{
+	uint8_t ip [] = {127, 0, 0, 1};
+	uint32_t received;
+	uint32_t i;
+
+	for(i=0; i<len; i++)
+		ref[i] = i;
+	ref_len = len;
+
+	udp_begin(sock, SIM_PORT, 0);
+	udp_set_remote(sock, ip, sink_port);
+	if(scn->irq)
+		wiz_socket_irq_set(sock, _irq_cb, WIZ_Sn_IR_SEND_OK);
+	else
+		wiz_socket_irq_unset(sock);
+
+	_sink_drain();
+	received = 0;
+	dispatched = 0;
+	memset(&sim_stats, 0, sizeof(sim_stats));
+	wiz_spi_stats_reset();
+
+	for(i=0; i<frames; i++)
+	{
+		scn->run(sock, ref, len);
+		received += _sink_drain(); // before the host socket overflows
+	}
+	udp_send_wait(sock);
+
+	received += _sink_drain() + dispatched;
+
+	// the driver's own accounting
+	const double us = wiz_spi_stats.cycles / (double)(SNTP_SYSTICK_CYCLES / SNTP_SYSTICK_US);
+	const uint32_t errors = wiz_spi_stats.dma_err + wiz_spi_stats.ovr + wiz_spi_stats.modf;
+
+	printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.2f %8u %4u %8u/%u\n", scn->name,
+		(double)sim_stats.frames / frames,
+		(double)sim_stats.xfers / frames,
+		(double)sim_stats.bytes / frames,
+		(double)sim_stats.bytes / frames - len,
+		us / frames,
+		errors, wiz_spi_divider(),
+		received, frames);
+}
+
+int
+main(int argc, char **argv)
+{
+	uint8_t mac [] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+	uint8_t ip [] = {127, 0, 0, 1};
+	uint8_t gateway [] = {127, 0, 0, 1};
+	uint8_t subnet [] = {255, 0, 0, 0};
+	uint8_t tx_mem [WIZ_MAX_SOCK_NUM] = {8, 2, 2, 1, 1, 1, 1, 0};
+	uint8_t rx_mem [WIZ_MAX_SOCK_NUM] = {8, 2, 2, 1, 1, 1, 1, 0};
+	uint32_t frames = SIM_FRAMES;
+	uint16_t len = SIM_SIZE;
+	uint_fast8_t adapt = 0;
+	const Scenario *scn;
+	uint_fast8_t i;
+	int c;
+
+	while((c = getopt(argc, argv, "n:s:e:a")) != -1)
+		switch(c)
+		{
+			case 'n':
+				frames = atoi(optarg);
+				break;
+			case 's':
+				len = atoi(optarg);
+				break;
+			case 'e':
+				sim_err_rate = atoi(optarg);
+				break;
+			case 'a':
+				adapt = 1;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n frames] [-s size] [-e overrun every n-th read] [-a]\n", argv[0]);
+				return -1;
+		}
+
+	// udp_dispatch drops datagrams which do not fit into its buffer together with their header
+	if( (len < 16) || (len > UDP_BULK_MAX - WIZ_UDP_HDR_SIZE) )
+	{
+		fprintf(stderr, "wizsim: size must be within 16..%u\n", UDP_BULK_MAX - WIZ_UDP_HDR_SIZE);
+		return -1;
+	}
+
+	for(i=0; i<WIZ_MAX_SOCK_NUM; i++)
+		sim_sock[i].fd = -1;
+	_sim_reset();
+
+	sink_fd = _host_socket(&sink_port);
+	source_fd = _host_socket(NULL);
+	if( (sink_fd < 0) || (source_fd < 0) )
+	{
+		perror("wizsim: socket");
+		return -1;
+	}
+
+	wiz_init(PIN_MAP[UDP_SS].gpio_device, PIN_MAP[UDP_SS].gpio_bit);
+	wiz_spi_adapt(adapt);
+	wiz_sockets_set(tx_mem, rx_mem);
+	wiz_comm_set(mac, ip, gateway, subnet);
+	if(!wiz_link_up())
+	{
+		fprintf(stderr, "wizsim: no link\n");
+		return -1;
+	}
+
+	printf("%-10s %10s %10s %10s %10s %10s %8s %4s %10s\n",
+		"scenario", "cs", "dma", "bytes", "overhead", "us", "errors", "div", "datagrams");
+	for(scn=scenarios; scn->name; scn++)
+		_scenario(scn, 0, frames, len);
+	printf("(SPI per datagram, %u datagrams of %u bytes each)\n", frames, len);
+
+	return 0;
+}
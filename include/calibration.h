@@ -24,6 +24,15 @@
 #ifndef _CALIBRATION_H_
 #define _CALIBRATION_H_
 
+#include <stdint.h>
+
+#include <oscquery.h>
+#include <sensors.h>
+
+#define CROSSTALK_STRIDE ((SENSOR_N + 1) & ~1) // even row length for dual 16-bit MACs
+#define CROSSTALK_Q 14 // fixed point fraction bits of crosstalk matrix
+#define CROSSTALK_ONE (1 << CROSSTALK_Q)
+
 typedef struct _Calibration Calibration;
 
 struct _Calibration {
@@ -31,13 +40,14 @@ struct _Calibration {
 	float Bmin [SENSOR_N]; // Bmin
 	float W [SENSOR_N]; // 1 / (Bmax - Bmin)
 	float C [SENSOR_N][3];
+	int16_t X [SENSOR_N][CROSSTALK_STRIDE] __attribute__((aligned(4))); // crosstalk compensation, Q14, zero padded
 };
 
 // globals
 extern Calibration range;
 extern uint_fast8_t zeroing;
 extern uint_fast8_t calibrating;
-extern const OSC_Query_Item calibration_tree [8];
+extern const OSC_Query_Item calibration_tree [9];
 
 uint_fast8_t range_load(uint_fast8_t pos);
 uint_fast8_t range_reset();
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include <stdint.h>
+
+#include <osc.h>
+#include <oscquery.h>
+#include <sensors.h>
+
+/*
+ * raw sensor capture, streamed to the debug socket
+ *
+ * /capture/range ,b    Calibration struct as laid out in MCU memory (little-endian)
+ * /capture/frames ,ib  SENSOR_N, blob of CAPTURE_BATCH frame records
+ *
+ * frame record (big-endian, CAPTURE_RECORD_SIZE bytes):
+ *   int32     frame number
+ *   timetag   sample timestamp (now)
+ *   timetag   bundle timestamp (now + output offset)
+ *   int16[]   SENSOR_N raw ADC values in sensor order, zero padded to 32 bits
+ *
+ * a capture file is the sequence of these OSC packets, each one prefixed
+ * with its size as big-endian int32 (the same as osc.tcp framing)
+ */
+
+#define CAPTURE_RECORD_SIZE (4 + 8 + 8 + round_to_four_bytes(SENSOR_N * sizeof(int16_t)))
+#define CAPTURE_BATCH 12 // records per message, fits into CHIMAERA_BUFSIZE even when SLIP encoded
+
+extern uint8_t capturing;
+extern const OSC_Query_Item capture_tree [1];
+
+void capture_frame(int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+void capture_flush();
+
+#endif // _CAPTURE_H_
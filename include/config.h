@@ -28,6 +28,8 @@
 
 #include <oscpod.h>
 #include <oscquery.h>
+#include <sensors.h>
+#include <engines.h>
 
 #define SRC_PORT 0
 #define DST_PORT 1
@@ -85,6 +87,7 @@ struct _Config {
 	 * read-only
 	 */
  	Firmware_Version version;
+	uint16_t layout; // sizeof(Config), catches layout changes without a version bump
 
 	/*
 	 * read-write
@@ -97,6 +100,7 @@ struct _Config {
 		uint8_t ip [4];
 		uint8_t gateway [4];
 		uint8_t subnet [4];
+		uint8_t spi_adapt; // step the WIZnet SPI clock down on error bursts
 	} comm;
 
 	struct _output {
@@ -107,6 +111,16 @@ struct _Config {
 			uint8_t z;
 		} invert;
 		uint8_t parallel;
+		uint8_t engine;
+		MIDI_Config midi;
+		uint8_t packed_q15;
+		uint8_t packed_fec;
+		Fingering_Config fingering;
+		struct {
+			uint8_t frames; // frames per datagram, 1 := no batching
+			OSC_Timetag latency; // ceiling from first frame to SEND
+		} batch;
+		uint8_t queue; // keep writing frames to TX memory while a SEND is in flight
 	} output;
 
 	struct _config {
@@ -144,10 +158,17 @@ struct _Config {
 
 	struct _sensors {
 		uint8_t movingaverage_bitshift;
-		uint16_t rate; // the maximal update rate the chimaera should run at
+		uint16_t rate; // the maximal update rate the chimaera should run at, breath sensor runs at it
+		uint8_t valve_divider; // valves are updated every valve_divider frames
+		uint8_t phase_lock; // align sample instants to whole periods of PTP time
+		Breath_Config breath;
+		Autozero_Config autozero;
 	} sensors;
 };
 
+#define SENSORS_RATE_MIN 25 // limited by 16-bit adc_timer reload
+#define SENSORS_RATE_MAX 10000
+
 extern Config config;
 extern const OSC_Method config_serv [];
 
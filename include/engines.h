@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _ENGINES_H_
+#define _ENGINES_H_
+
+#include <stdint.h>
+
+#include <osc.h>
+#include <sensors.h>
+
+typedef osc_data_t *(*Engine_Frame_Cb)(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+typedef enum _Engine_Type Engine_Type;
+typedef enum _MIDI_Mode MIDI_Mode;
+typedef struct _MIDI_Config MIDI_Config;
+typedef struct _Fingering_Entry Fingering_Entry;
+typedef struct _Fingering_Config Fingering_Config;
+
+enum _Engine_Type {
+	ENGINE_DUMP_RAW	= 0,
+	ENGINE_DUMP_VAL	= 1,
+	ENGINE_LOSSLESS	= 2,
+	ENGINE_LOSSY		= 3,
+	ENGINE_MIDI			= 4,
+	ENGINE_PACKED		= 5,
+	ENGINE_FINGERING	= 6,
+	ENGINE_N				= 7
+};
+
+enum _MIDI_Mode {
+	MIDI_MODE_CC		= 0, // 14-bit controller pair per sensor
+	MIDI_MODE_MPE		= 1  // note + pitch bend per valve on member channels, breath as pressure
+};
+
+struct _MIDI_Config {
+	uint8_t mode;
+	uint8_t channel; // CC channel or MPE manager channel, members follow
+	uint8_t cc [SENSOR_N]; // MSB controller 0-31, LSB is cc+32
+	uint8_t note [SENSOR_N];
+};
+
+#define MIDI_CONFIG_DEFAULT { \
+	.mode = MIDI_MODE_CC, \
+	.channel = 0, \
+	.cc = {20, 21, 22, 23, 24, 25, 26, 27, 2}, \
+	.note = {60, 62, 64, 65, 67, 69, 71, 72, 0} \
+}
+
+/*
+ * packed engine, a single message per frame without enclosing bundle
+ *
+ * /pkd ,b  blob of PACKED_SIZE bytes (big-endian):
+ *   uint8     version (PACKED_VERSION)
+ *   uint8     flags (PACKED_FLAG_Q15: values are Q15 normalized, else raw ADC)
+ *   uint8     SENSOR_N
+ *   uint8     FEC group size, 0 := no FEC
+ *   int32     frame number
+ *   timetag   sample timestamp (now)
+ *   uint32    sensor states (ADC_State), 2 bits each, sensor 0 in the LSBs
+ *   int16[]   SENSOR_N values in sensor order
+ *
+ * with FEC, frames are grouped by frame number / group size, the XOR
+ * parity of a group's blobs rides along with the first frame of the next
+ * group, both messages in an offset bundle:
+ *
+ * /fec ,iib  first frame number and size of the group, parity blob of PACKED_SIZE bytes
+ *
+ * a receiver can rebuild a single lost frame per group from the parity and
+ * the other frames of that group, FEC is unavailable with batching, as it
+ * would put frames and parity into the same datagram
+ *
+ * decoders must check version and skip trailing bytes of larger frames
+ */
+
+#define PACKED_VERSION 1
+#define PACKED_FLAG_Q15 0x1
+#define PACKED_FEC_MAX 32
+#define PACKED_SIZE (4 + 4 + 8 + 4 + SENSOR_N*sizeof(int16_t))
+
+/*
+ * fingering engine, resolves the closed valves to a note on the device
+ *
+ * a valve counts as closed when on and above threshold, the first entry with
+ * (closed & care) == mask gives the note, which sounds while breath is on
+ *
+ * /note/on ,if   note, breath
+ * /note/off ,i   note
+ * /note/exp ,f   breath of the sounding note
+ *
+ * switching to another engine sends a last bundle with the pending note-off
+ */
+
+#define FINGERING_MAX 32
+
+struct _Fingering_Entry {
+	uint8_t mask; // closed valves, valve 0 in the LSB
+	uint8_t care; // valves taken into account
+	uint8_t note;
+};
+
+struct _Fingering_Config {
+	float threshold; // valve value above which it counts as closed
+	float settle; // time a fingering must be stable before it sounds
+	uint8_t size; // used entries
+	Fingering_Entry table [FINGERING_MAX];
+};
+
+// D whistle on valves 0-5 from the top, valves 6 and 7 are ignored
+#define FINGERING_CONFIG_DEFAULT { \
+	.threshold = 0.5f, \
+	.settle = 0.005f, \
+	.size = 8, \
+	.table = { \
+		{0x3f, 0x3f, 62}, \
+		{0x1f, 0x3f, 64}, \
+		{0x0f, 0x3f, 66}, \
+		{0x07, 0x3f, 67}, \
+		{0x03, 0x3f, 69}, \
+		{0x01, 0x3f, 71}, \
+		{0x06, 0x3f, 72}, \
+		{0x00, 0x3f, 73} \
+	} \
+}
+
+extern const Engine_Frame_Cb engines_frame_cb [ENGINE_N];
+
+void packed_configure(uint8_t q15, uint8_t fec);
+void fingering_configure(const Fingering_Config *cfg);
+osc_data_t *fingering_release(osc_data_t *buf, OSC_Timetag offset); // note-off of a sounding note
+
+void midi_configure(const MIDI_Config *cfg);
+osc_data_t *midi_release(osc_data_t *buf, OSC_Timetag offset); // note-off of all sounding MPE notes
+
+osc_data_t *engines_dump_raw(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+osc_data_t *engines_dump_val(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+osc_data_t *engines_lossless(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+osc_data_t *engines_lossy(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+osc_data_t *engines_midi(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+osc_data_t *engines_packed(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+osc_data_t *engines_fingering(osc_data_t *buf, int32_t frm, OSC_Timetag now, OSC_Timetag offset);
+
+#endif // _ENGINES_H_
@@ -24,6 +24,9 @@
 #ifndef _LINALG_H_
 #define _LINALG_H_
 
+#include <stdint.h>
+
 void linalg_least_squares_cubic(double x1, double y1, double x2, double y2, double x3, double y3, double *C0, double *C1, double *C2);
+uint_fast8_t linalg_invert(float *A, float *B, uint_fast8_t n);
 
 #endif // _LINALG_H_
@@ -42,7 +42,8 @@ extern const stm32_pin_info PIN_MAP [];
 #define pin_write_bit(PIN, VAL)(gpio_write_bit(PIN_MAP[(PIN)].gpio_device, PIN_MAP[(PIN)].gpio_bit,(VAL)))
 #define pin_read_bit(PIN)(gpio_read_bit(PIN_MAP[(PIN)].gpio_device, PIN_MAP[(PIN)].gpio_bit))
 
-#define SENSOR_N 9
+#include <sensors.h> // SENSOR_N
+
 #define ADC_LENGTH 9
 #define ADC_DUAL_LENGTH 4
 #define ADC_SING_LENGTH 1
@@ -34,6 +34,8 @@ extern const OSC_Query_Item ptp_tree [6];
 void ptp_reset();
 int64_t ptp_uptime();
 void ptp_timestamp_refresh(int64_t tick, OSC_Timetag *now, OSC_Timetag *offset);
+void ptp_timestamp_refresh_cycles(uint32_t tick, uint32_t cycles, OSC_Timetag *now, OSC_Timetag *offset);
+uint_fast8_t ptp_phase(uint32_t tick, uint32_t cycles, uint32_t period_ns, int32_t *phase_ns);
 void ptp_request();
 void ptp_dispatch(uint8_t *buf, int64_t tick);
 
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#ifndef _SENSORS_H_
+#define _SENSORS_H_
+
+#include <stdint.h>
+
+#define SENSOR_N 9
+#define SENSOR_BREATH (SENSOR_N - 1) // pressure sensor, all others are valves
+
+// sensor groups with independent update rates
+#define SENSORS_GROUP_VALVES	0x1
+#define SENSORS_GROUP_BREATH	0x2
+#define SENSORS_GROUP_ALL			(SENSORS_GROUP_VALVES | SENSORS_GROUP_BREATH)
+
+#define sensors_group(i) ((i) == SENSOR_BREATH ? SENSORS_GROUP_BREATH : SENSORS_GROUP_VALVES)
+#define sensors_is_fresh(i) (sensors_fresh & sensors_group(i))
+
+typedef struct _ADC_Filter ADC_Filter;
+typedef enum _ADC_State ADC_State;
+typedef struct _Breath_Config Breath_Config;
+typedef struct _Autozero_Config Autozero_Config;
+typedef enum _Breath_Shape Breath_Shape;
+
+struct _ADC_Filter {
+	float Os;
+	float O0, O1;
+	float OO0, OO1;
+};
+
+enum _ADC_State {
+	ADC_STATE_IDLE	= 0,
+	ADC_STATE_ON,
+	ADC_STATE_OFF,
+	ADC_STATE_SET
+};
+
+enum _Breath_Shape {
+	BREATH_SHAPE_LIN	= 0,
+	BREATH_SHAPE_LOG	= 1,
+	BREATH_SHAPE_EXP	= 2
+};
+
+// breath processor settings, embedded in Config
+struct _Breath_Config {
+	float attack; // envelope attack time constant [s]
+	float release; // envelope release time constant [s]
+	float adapt; // noise floor adaption time constant [s]
+	float open; // gate opens at envelope above noise floor
+	float close; // gate closes at envelope below noise floor + close, close < open
+	float curve; // curvature of log/exp response
+	uint8_t shape; // Breath_Shape
+};
+
+#define BREATH_CONFIG_DEFAULT { \
+	.attack = 0.001f, \
+	.release = 0.02f, \
+	.adapt = 2.f, \
+	.open = 0.04f, \
+	.close = 0.02f, \
+	.curve = 4.f, \
+	.shape = BREATH_SHAPE_LIN \
+}
+
+#define BREATH_RATE_DEFAULT 2000 // assumed frame rate when running unthrottled
+
+// quiescent drift tracking settings, embedded in Config
+struct _Autozero_Config {
+	float time; // tracking time constant [s]
+	float bound; // maximal runtime offset from calibrated quiescent [ADC LSB]
+	uint8_t enabled;
+};
+
+#define AUTOZERO_CONFIG_DEFAULT { \
+	.time = 30.f, \
+	.bound = 64.f, \
+	.enabled = 1 \
+}
+
+// globals
+extern int16_t *adc_raw; // points to the frame currently processed
+extern float adc_val0 [SENSOR_N];
+extern float adc_val1 [SENSOR_N];
+extern ADC_Filter adc_filt [SENSOR_N];
+extern ADC_State adc_state [SENSOR_N];
+extern uint_fast8_t sensors_fresh; // groups refreshed by last sensors_update
+extern float adc_drift [SENSOR_N]; // runtime quiescent offset, never saved
+
+void sensors_update(uint_fast8_t groups);
+void breath_configure(const Breath_Config *cfg, uint16_t rate);
+void autozero_configure(const Autozero_Config *cfg, uint16_t rate);
+void autozero_reset();
+void autozero_commit();
+
+#endif // _SENSORS_H_
@@ -40,13 +40,18 @@
 #define SNTP_SYSTICK_RATE 1000 // 1000 Hz
 #define SNTP_SYSTICK_US 1000
 
+#define SNTP_SYSTICK_CYCLES (SNTP_SYSTICK_RELOAD_VAL + 1) // core cycles per tick
+#define SNTP_SYSTICK_FRACTION(cycles) (SNTP_SYSTICK_DURATION * (cycles) / SNTP_SYSTICK_CYCLES)
+
 extern fix_s31_32_t clock_offset;
 extern fix_32_32_t roundtrip_delay;
 extern const OSC_Query_Item sntp_tree [5];
 
 void sntp_reset();
 uint32_t sntp_uptime();
+uint32_t sntp_uptime_cycles(uint32_t *cycles);
 void sntp_timestamp_refresh(uint32_t tick, OSC_Timetag *now, OSC_Timetag *offset);
+void sntp_timestamp_refresh_cycles(uint32_t tick, uint32_t cycles, OSC_Timetag *now, OSC_Timetag *offset);
 uint16_t sntp_request(uint8_t *buf, OSC_Timetag t3);
 void sntp_dispatch(uint8_t *buf, OSC_Timetag t4);
 
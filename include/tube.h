@@ -26,7 +26,8 @@
 
 #include <libmaple/dma.h>
 
-extern dma_tube_config adc_tube12;
+extern dma_tube_config adc_tube1;
+extern dma_tube_config adc_tube2;
 extern dma_tube_config adc_tube3;
 extern dma_tube_config spi_rx_tube;
 extern dma_tube_config spi_tx_tube;
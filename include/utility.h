@@ -42,6 +42,8 @@ void mdns_timer_reconfigure();
 void ptp_timer_reconfigure(float sec);
 
 void output_enable(uint8_t b);
+void output_batch_reset(uint_fast8_t lost);
+void output_irq_update();
 void config_enable(uint8_t b);
 void sntp_enable(uint8_t b);
 void ptp_enable(uint8_t b);
@@ -49,6 +51,9 @@ void debug_enable(uint8_t b);
 void mdns_enable(uint8_t b);
 void dhcpc_enable(uint8_t b);
 
+void sockets_partition(uint8_t *tx_mem, uint8_t *rx_mem);
+void sockets_repartition();
+
 typedef struct _Stop_Watch Stop_Watch;
 
 struct _Stop_Watch {
@@ -59,6 +59,15 @@ extern const uint8_t wiz_broadcast_mac [];
 typedef void(*Wiz_UDP_Dispatch_Cb)(uint8_t *ip, uint16_t port, uint8_t *buf, uint16_t len);
 typedef void(*Wiz_IRQ_Cb)(uint8_t isr);
 typedef enum _Wiz_Socket_State Wiz_Socket_State;
+typedef struct _Wiz_Vec Wiz_Vec;
+
+// scatter-gather segment, needs no spare header bytes in front
+struct _Wiz_Vec {
+	uint8_t *buf;
+	uint16_t len;
+};
+
+#define WIZ_MAX_VEC_NUM 4
 
 enum _Wiz_Socket_State {
 	WIZ_SOCKET_STATE_CLOSED		= 0,
@@ -68,8 +77,28 @@ enum _Wiz_Socket_State {
 
 extern Wiz_Socket_State wiz_socket_state [];
 
+typedef struct _Wiz_SPI_Stats Wiz_SPI_Stats;
+
+// SPI link statistics, updated by the DMA ISRs
+struct _Wiz_SPI_Stats {
+	uint32_t frames; // completed transactions
+	uint32_t bytes; // clocked over the bus, including headers and retries
+	uint64_t cycles; // core cycles with chip select asserted
+	uint32_t dma_err; // DMA transfer errors
+	uint32_t ovr; // SPI overruns
+	uint32_t modf; // SPI mode faults
+	uint32_t dropped; // jobs given up after WIZ_JOB_RETRY_MAX errors
+};
+
+extern volatile Wiz_SPI_Stats wiz_spi_stats;
+
+void wiz_spi_stats_reset();
+void wiz_spi_adapt(uint_fast8_t enable);
+uint16_t wiz_spi_divider();
+
 void wiz_init(gpio_dev *dev, uint8_t bit);
 void wiz_sockets_set(uint8_t tx_mem[WIZ_MAX_SOCK_NUM], uint8_t rx_mem[WIZ_MAX_SOCK_NUM]);
+void wiz_sockets_get(uint8_t tx_mem[WIZ_MAX_SOCK_NUM], uint8_t rx_mem[WIZ_MAX_SOCK_NUM]);
 uint_fast8_t wiz_link_up();
 
 void wiz_mac_set(uint8_t *mac);
@@ -104,7 +133,11 @@ void udp_set_remote_har(uint8_t sock, uint8_t *har);
 
 void udp_send(uint8_t sock, uint8_t *o_buf, uint16_t len);
 uint_fast8_t udp_send_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len);
+uint_fast8_t udp_append_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len, uint_fast8_t send);
+uint_fast8_t udp_sendv_nonblocking(uint8_t sock, const Wiz_Vec *vec, uint_fast8_t n);
+uint_fast8_t udp_queue_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len);
 void udp_send_block(uint8_t sock);
+void udp_send_wait(uint8_t sock);
 
 uint16_t udp_available(uint8_t sock);
 
@@ -127,7 +160,9 @@ void tcp_end(uint8_t sock);
 
 void tcp_send(uint8_t sock, uint8_t *o_buf, uint16_t len);
 #define tcp_send_nonblocking udp_send_nonblocking
+#define tcp_sendv_nonblocking udp_sendv_nonblocking
 void tcp_send_block(uint8_t sock);
+#define tcp_send_wait udp_send_wait
 
 #define tcp_receive udp_receive
 #define tcp_peek udp_peek
@@ -144,6 +179,7 @@ void tcp_dispatch(uint8_t sock, uint8_t *i_buf, Wiz_UDP_Dispatch_Cb cb, uint8_t
 void osc_send(OSC_Config *osc, uint8_t *o_buf, uint16_t len);
 uint_fast8_t osc_send_nonblocking(OSC_Config *osc, uint8_t *o_buf, uint16_t len);
 void osc_send_block(OSC_Config *osc);
+void osc_sendv(OSC_Config *osc, const Wiz_Vec *vec, uint_fast8_t n);
 
 void osc_dispatch(OSC_Config *osc, uint8_t *i_buf, Wiz_UDP_Dispatch_Cb cb);
 
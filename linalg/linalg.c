@@ -96,3 +96,64 @@ linalg_least_squares_cubic(double x1, double y1, double x2, double y2, double x3
 
 	*C2 =(a3*((-b9)*(1+c4)+c4*(-1+c+c4-c5)+b8*(1+c5)+b5*(1+c8)-b4*(1+c9))*y1+a2*(pow(-1+c,2.0)*c5*(1+c+c2)+b9*(1+c5)-b8*(1+c6)-b6*(1+c8)+b5*(1+c9))*y1+(-1+b)*b2*(-1+c)*c2*(b+b2+b3-c*(1+c+c2))*(c2*(b3-b2*c+(-1+c)*y2)-(-1+b)*b2*y3)+a9*((-1+b)*b4+(-1+c)*c4+b2*(1+c5-b*(1+c4))*y2+c2*(1+b5-(1+b4)*c)*y3)+a5*(-2*c5+c8+c9+b2*(-2*b3+b6+b7+y2+c9*y2-2*b4*(1+c5)*y2+b*(1+c8)*y2)+c2*(1+b9+c+b8*c-2*(1+b5)*c4)*y3)+a8*((-(-1+b))*b5-(-1+c)*c5+b2*(-1+b+b*c5-c6)*y2+c2*(-1+c+b5*(-b+c))*y3)+a6*(-2*b5*(1+c5)*y1+c4*(1-c4+pow(-1+c,2.0)*y1)-b2*(1+c8)*y2+b6*(1+c4)*(y1+y2)+c2*(-1+c4)*y3-b8*(1+c2*y3)+b4*(1+y1+c6*y1+c6*y3))+a4*((-b3)*(1+c9)*y2-c3*(-1+c3)*(c3-y3)-b9*(1+c3*y3)+b6*(1+y2+c6*y2+c6*y3))) / divisor;
 }
+
+/*
+ * Gauss-Jordan inversion with partial pivoting
+ *
+ * A: n*n row-major matrix, gets destroyed
+ * B: n*n row-major inverse of A
+ *
+ * returns 0 for singular matrices
+ */
+uint_fast8_t
+linalg_invert(float *A, float *B, uint_fast8_t n)
+{
+	uint_fast8_t i, j, k;
+
+	for(i=0; i<n; i++)
+		for(j=0; j<n; j++)
+			B[i*n + j] = i == j ? 1.f : 0.f;
+
+	for(k=0; k<n; k++)
+	{
+		// find pivot
+		uint_fast8_t p = k;
+		for(i=k+1; i<n; i++)
+			if(fabsf(A[i*n + k]) > fabsf(A[p*n + k]))
+				p = i;
+		if(fabsf(A[p*n + k]) < 1e-6f)
+			return 0;
+
+		// swap rows
+		if(p != k)
+			for(j=0; j<n; j++)
+			{
+				float t;
+				t = A[k*n + j]; A[k*n + j] = A[p*n + j]; A[p*n + j] = t;
+				t = B[k*n + j]; B[k*n + j] = B[p*n + j]; B[p*n + j] = t;
+			}
+
+		// normalize pivot row
+		float d = 1.f / A[k*n + k];
+		for(j=0; j<n; j++)
+		{
+			A[k*n + j] *= d;
+			B[k*n + j] *= d;
+		}
+
+		// eliminate column in other rows
+		for(i=0; i<n; i++)
+		{
+			float f = A[i*n + k];
+			if( (i == k) || (f == 0.f) )
+				continue;
+			for(j=0; j<n; j++)
+			{
+				A[i*n + j] -= f * A[k*n + j];
+				B[i*n + j] -= f * B[k*n + j];
+			}
+		}
+	}
+
+	return 1;
+}
@@ -109,17 +109,12 @@ ptp_announce_ntoh(PTP_Announce *ann)
 int64_t __CCM_TEXT__
 ptp_uptime()
 {
-	volatile uint32_t ticks;
-	volatile uint32_t cycle_cnt;
-
-	do {
-		cycle_cnt = systick_get_count();
-		ticks = systick_uptime();
-	} while (ticks != systick_uptime());
+	uint32_t cycles;
+	uint32_t ticks = sntp_uptime_cycles(&cycles); // same tick period and wrap handling as sNTP
 
 	int64_t uptime;
 	uptime = (int64_t)ticks * SNTP_SYSTICK_US;
-	uptime += (SNTP_SYSTICK_RELOAD_VAL + 1 - cycle_cnt) / CYCLES_PER_MICROSECOND;
+	uptime += cycles / CYCLES_PER_MICROSECOND;
 
 	return uptime;
 }
@@ -424,6 +419,36 @@ ptp_timestamp_refresh(int64_t tick, OSC_Timetag *now, OSC_Timetag *offset)
 	}
 }
 
+void __CCM_TEXT__
+ptp_timestamp_refresh_cycles(uint32_t tick, uint32_t cycles, OSC_Timetag *now, OSC_Timetag *offset)
+{
+	OSC_Timetag frac = SNTP_SYSTICK_FRACTION(cycles);
+
+	ptp_timestamp_refresh((int64_t)tick * SNTP_SYSTICK_US, now, offset);
+
+	*now += frac;
+	if(offset && (*offset != OSC_IMMEDIATE) )
+		*offset += frac;
+}
+
+// phase of a sample instant relative to whole periods since PTP epoch
+uint_fast8_t __CCM_TEXT__
+ptp_phase(uint32_t tick, uint32_t cycles, uint32_t period_ns, int32_t *phase_ns)
+{
+	if(t0 == 0ULL) // not yet synchronized
+		return 0;
+
+	int64_t us = TICK_TO_US((int64_t)tick * SNTP_SYSTICK_US);
+	uint64_t ns = us * 1000 + cycles * 1000 / CYCLES_PER_MICROSECOND;
+	int32_t phase = ns % period_ns;
+
+	if(phase > (int32_t)(period_ns / 2)) // late by less than half a period, else early
+		phase -= period_ns;
+	*phase_ns = phase;
+
+	return 1;
+}
+
 void
 ptp_dispatch(uint8_t *buf, int64_t tick)
 {
@@ -31,6 +31,9 @@ BUILDDIRS += $(BUILD_PATH)/$(d)/dhcpc
 BUILDDIRS += $(BUILD_PATH)/$(d)/arp
 BUILDDIRS += $(BUILD_PATH)/$(d)/linalg
 BUILDDIRS += $(BUILD_PATH)/$(d)/calibration
+BUILDDIRS += $(BUILD_PATH)/$(d)/sensors
+BUILDDIRS += $(BUILD_PATH)/$(d)/engines
+BUILDDIRS += $(BUILD_PATH)/$(d)/capture
 
 ### Local flags: these control how the compiler gets called.
 
@@ -104,6 +107,9 @@ cSRCS_$(d) += dhcpc/dhcpc.c
 cSRCS_$(d) += arp/arp.c
 cSRCS_$(d) += linalg/linalg.c
 cSRCS_$(d) += calibration/calibration.c
+cSRCS_$(d) += sensors/sensors.c
+cSRCS_$(d) += engines/engines.c
+cSRCS_$(d) += capture/capture.c
 cSRCS_$(d) += firmware.c
 
 # cppSRCS_$(d) are the C++ sources we want compiled.  We have our own
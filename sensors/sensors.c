@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2014 Hanspeter Portner (dev@open-music-kontrollers.ch)
+ * 
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ * 
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ * 
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ * 
+ *     2. Altered source versions must be plainly marked as such, and must not be
+ *     misrepresented as being the original software.
+ * 
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ */
+
+#include <math.h>
+
+#include <sensors.h>
+#include <calibration.h>
+
+/*
+ * hardware independent sensor processing, shared by the firmware and the host tools
+ */
+
+#define FILT_STIFFNESS 16.f
+
+// globals
+int16_t *adc_raw;
+float adc_val0 [SENSOR_N];
+float adc_val1 [SENSOR_N];
+
+ADC_Filter adc_filt [SENSOR_N] = {
+	[0] = { .Os = 1.f / FILT_STIFFNESS },
+	[1] = { .Os = 1.f / FILT_STIFFNESS },
+	[2] = { .Os = 1.f / FILT_STIFFNESS },
+	[3] = { .Os = 1.f / FILT_STIFFNESS },
+	[4] = { .Os = 1.f / FILT_STIFFNESS },
+	[5] = { .Os = 1.f / FILT_STIFFNESS },
+	[6] = { .Os = 1.f / FILT_STIFFNESS },
+	[7] = { .Os = 1.f / FILT_STIFFNESS },
+	[8] = { .Os = 1.f / FILT_STIFFNESS }
+};
+
+ADC_State adc_state [SENSOR_N];
+uint_fast8_t sensors_fresh = 0;
+
+float adc_drift [SENSOR_N];
+
+typedef struct _Autozero Autozero;
+typedef struct _Breath Breath;
+
+struct _Autozero {
+	const Autozero_Config *cfg;
+	float k; // per-frame coefficient
+};
+
+static Autozero autozero = {
+	.cfg = NULL
+};
+
+struct _Breath {
+	const Breath_Config *cfg;
+
+	// per-sample coefficients
+	float attack;
+	float release;
+	float adapt;
+	float norm; // 1 / shape(1)
+
+	float env; // envelope
+	float floor; // noise floor
+	uint_fast8_t open; // gate
+};
+
+static Breath breath = {
+	.cfg = NULL
+};
+
+static inline float
+_breath_coefficient(float tau, uint16_t rate)
+{
+	return tau > 0.f ? 1.f - expf(-1.f / (tau * rate)) : 1.f;
+}
+
+void
+breath_configure(const Breath_Config *cfg, uint16_t rate)
+{
+	if(!rate)
+		rate = BREATH_RATE_DEFAULT;
+
+	breath.attack = _breath_coefficient(cfg->attack, rate);
+	breath.release = _breath_coefficient(cfg->release, rate);
+	breath.adapt = _breath_coefficient(cfg->adapt, rate);
+
+	switch(cfg->shape)
+	{
+		case BREATH_SHAPE_LOG:
+			breath.norm = 1.f / logf(1.f + cfg->curve);
+			break;
+		case BREATH_SHAPE_EXP:
+			breath.norm = 1.f / (expf(cfg->curve) - 1.f);
+			break;
+		default:
+			breath.norm = 1.f;
+			break;
+	}
+
+	breath.cfg = cfg;
+}
+
+void
+autozero_configure(const Autozero_Config *cfg, uint16_t rate)
+{
+	if(!rate)
+		rate = BREATH_RATE_DEFAULT;
+
+	autozero.k = _breath_coefficient(cfg->time, rate);
+	autozero.cfg = cfg;
+}
+
+void
+autozero_reset()
+{
+	uint_fast8_t i;
+
+	for(i=0; i<SENSOR_N; i++)
+		adc_drift[i] = 0.f;
+}
+
+// fold runtime offsets into the calibration in RAM, saving it to EEPROM is up to the user
+void
+autozero_commit()
+{
+	uint_fast8_t i;
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		int16_t d = lrintf(adc_drift[i]);
+
+		range.Q[i] += d;
+		range.Bmin[i] += d;
+		adc_drift[i] -= d;
+	}
+}
+
+// slowly follow the quiescent level of idle valves within configured bounds
+static inline void
+_autozero_track(uint_fast8_t i, float x)
+{
+	const Autozero_Config *cfg = autozero.cfg;
+
+	if(!cfg || !cfg->enabled || calibrating // quiescent reference is being measured anew
+		|| (i == SENSOR_BREATH) // breath has its own adaptive floor
+		|| (adc_state[i] != ADC_STATE_IDLE) || (range.Q[i] == 0) ) // no quiescent reference before calibration
+		return;
+
+	float d = adc_drift[i] + autozero.k * (x - range.Q[i] - adc_drift[i]);
+
+	if(d > cfg->bound)
+		d = cfg->bound;
+	else if(d < -cfg->bound)
+		d = -cfg->bound;
+
+	adc_drift[i] = d;
+}
+
+// envelope follower, adaptive noise gate and response shaping, runs every frame
+static inline ADC_State
+_breath_process(float *val)
+{
+	const Breath_Config *cfg = breath.cfg;
+	uint_fast8_t was_open = breath.open;
+	float x = *val;
+	float y;
+
+	// attack/release envelope
+	breath.env += (x > breath.env ? breath.attack : breath.release) * (x - breath.env);
+
+	// noise floor only adapts while gate is closed, gate has hysteresis
+	if(!was_open)
+	{
+		breath.floor += breath.adapt * (breath.env - breath.floor);
+		if(breath.env > breath.floor + cfg->open)
+			breath.open = 1;
+	}
+	else if(breath.env < breath.floor + cfg->close)
+		breath.open = 0;
+
+	y = breath.open ? breath.env - breath.floor : 0.f;
+	if(y < 0.f)
+		y = 0.f;
+	else if(y > 1.f)
+		y = 1.f;
+
+	switch(cfg->shape)
+	{
+		case BREATH_SHAPE_LOG:
+			y = logf(1.f + cfg->curve * y) * breath.norm;
+			break;
+		case BREATH_SHAPE_EXP:
+			y = (expf(cfg->curve * y) - 1.f) * breath.norm;
+			break;
+	}
+
+	*val = y;
+
+	if(breath.open)
+		return was_open ? ADC_STATE_SET : ADC_STATE_ON;
+	else
+		return was_open ? ADC_STATE_OFF : ADC_STATE_IDLE;
+}
+
+// dual 16-bit multiply-accumulate: acc + x.lo*y.lo + x.hi*y.hi
+#if defined(__ARM_ARCH_7EM__)
+#	define smlad(x, y, acc) \
+({ \
+	int32_t z; \
+	asm volatile("\tsmlad	%[Z], %[X], %[Y], %[A]\n" \
+		: [Z]"=r"(z) \
+		: [X]"r"(x), [Y]"r"(y), [A]"r"(acc) \
+	); \
+	z; \
+})
+#else
+#	define smlad(x, y, acc) \
+	((acc) + (int32_t)(int16_t)(x) * (int16_t)(y) + (int32_t)(int16_t)((x) >> 16) * (int16_t)((y) >> 16))
+#endif
+
+static inline int16_t
+_crosstalk_q(float x)
+{
+	x *= CROSSTALK_ONE;
+
+	if(x >= 32767.f)
+		return 32767;
+	else if(x <= -32768.f)
+		return -32768;
+	return x;
+}
+
+// one row of crosstalk compensation in Q14
+static inline float
+_crosstalk_row(const int16_t *row, const int16_t *vec)
+{
+	const uint32_t *r = (const uint32_t *)row;
+	const uint32_t *v = (const uint32_t *)vec;
+	int32_t acc = 0;
+	uint_fast8_t k;
+
+	for(k=0; k<CROSSTALK_STRIDE/2; k++)
+		acc = smlad(r[k], v[k], acc);
+
+	return acc * (1.f / ((int32_t)CROSSTALK_ONE * CROSSTALK_ONE));
+}
+
+// filters every sensor at frame rate, normalizes, linearizes and updates state of given groups only
+void __CCM_TEXT__
+sensors_update(uint_fast8_t groups)
+{
+	uint_fast8_t i;
+	int16_t norm [CROSSTALK_STRIDE] __attribute__((aligned(4)));
+
+	sensors_fresh = groups;
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		ADC_Filter *filt = &adc_filt[i];
+
+		// filter signal, doubles as anti-aliasing for decimated groups
+		filt->O1 = adc_raw[i];
+		filt->OO1 = filt->Os * (filt->O0 + filt->O1) / 2.f + filt->OO0 * (1.f - filt->Os);
+		filt->O0 = filt->O1;
+		filt->OO0 = filt->OO1;
+
+		_autozero_track(i, filt->OO1);
+
+		// normalize, every sensor is needed for crosstalk compensation
+		norm[i] = _crosstalk_q( (filt->OO1 - adc_drift[i] - range.Bmin[i]) * range.W[i]);
+	}
+	for( ; i<CROSSTALK_STRIDE; i++)
+		norm[i] = 0;
+
+	for(i=0; i<SENSOR_N; i++)
+	{
+		if(!sensors_is_fresh(i))
+			continue;
+
+		// compensate magnetic crosstalk of neighbouring valves
+		adc_val1[i] = _crosstalk_row(range.X[i], norm);
+
+		// dedicated processor with own state for pressure sensor
+		if( (i == SENSOR_BREATH) && breath.cfg)
+		{
+			adc_state[i] = _breath_process(&adc_val1[i]);
+			adc_val0[i] = adc_val1[i];
+			continue;
+		}
+
+		// linearization skip for pressure sensor
+		if(i != SENSOR_BREATH)
+			adc_val1[i] = range.C[i][0] * cbrtf(adc_val1[i])
+									+ range.C[i][1] * sqrtf(adc_val1[i])
+									+ range.C[i][2] *       adc_val1[i];
+
+		// update state
+		if(adc_val1[i] > 0.f)
+		{
+			if(adc_val0[i] > 0.f)
+				adc_state[i] = ADC_STATE_SET;
+			else
+				adc_state[i] = ADC_STATE_ON;
+		}
+		else // adc_val1[i] <= 0.f
+		{
+			if(adc_val0[i] > 0.f)
+				adc_state[i] = ADC_STATE_OFF;
+			else
+				adc_state[i] = ADC_STATE_IDLE;
+		}
+		adc_val0[i] = adc_val1[i];
+	}
+}
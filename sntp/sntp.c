@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include <libmaple/systick.h>
+#include <libmaple/scb.h>
 
 #include "sntp_private.h"
 
@@ -155,6 +156,39 @@ sntp_timestamp_refresh(uint32_t tick, OSC_Timetag *now, OSC_Timetag *offset)
 	}
 }
 
+// returns systick ticks since startup and core cycles elapsed into the current tick
+uint32_t __CCM_TEXT__
+sntp_uptime_cycles(uint32_t *cycles)
+{
+	volatile uint32_t ticks;
+	volatile uint32_t cycle_cnt;
+
+	do {
+		cycle_cnt = systick_get_count();
+		ticks = systick_uptime();
+	} while (ticks != systick_uptime());
+
+	// counter has wrapped but tick interrupt is still pending (e.g. called from a higher priority ISR)
+	if( (SCB_BASE->ICSR & SCB_ICSR_PENDSTSET) && (cycle_cnt > SNTP_SYSTICK_RELOAD_VAL / 2) )
+		ticks++;
+
+	*cycles = SNTP_SYSTICK_RELOAD_VAL - cycle_cnt; // counts down
+
+	return ticks;
+}
+
+void __CCM_TEXT__
+sntp_timestamp_refresh_cycles(uint32_t tick, uint32_t cycles, OSC_Timetag *now, OSC_Timetag *offset)
+{
+	OSC_Timetag frac = SNTP_SYSTICK_FRACTION(cycles);
+
+	sntp_timestamp_refresh(tick, now, offset);
+
+	*now += frac;
+	if(offset && (*offset != OSC_IMMEDIATE) )
+		*offset += frac;
+}
+
 /*
  * Config
  */
@@ -29,24 +29,35 @@
 #include <libmaple/adc.h>
 #include <libmaple/spi.h>
 
-dma_tube_config adc_tube12 = {
-	.tube_src = &ADC12_BASE->CDR,
-	.tube_src_size = DMA_SIZE_32BITS,
+dma_tube_config adc_tube1 = {
+	.tube_src = &ADC1_BASE->DR,
+	.tube_src_size = DMA_SIZE_16BITS,
 	.tube_dst = NULL, //set me
-	.tube_dst_size = DMA_SIZE_32BITS,
+	.tube_dst_size = DMA_SIZE_16BITS,
 	.tube_nr_xfers = 0, //set me
-	.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CIRC | DMA_CFG_HALF_CMPLT_IE | DMA_CFG_CMPLT_IE,
+	.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CMPLT_IE,
 	.target_data = NULL,
 	.tube_req_src = DMA_REQ_SRC_ADC1
 };
 
+dma_tube_config adc_tube2 = {
+	.tube_src = &ADC2_BASE->DR,
+	.tube_src_size = DMA_SIZE_16BITS,
+	.tube_dst = NULL, //set me
+	.tube_dst_size = DMA_SIZE_16BITS,
+	.tube_nr_xfers = 0, //set me
+	.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CMPLT_IE,
+	.target_data = NULL,
+	.tube_req_src = DMA_REQ_SRC_ADC2
+};
+
 dma_tube_config adc_tube3 = {
 	.tube_src = &ADC3_BASE->DR,
 	.tube_src_size = DMA_SIZE_16BITS,
 	.tube_dst = NULL, //set me
 	.tube_dst_size = DMA_SIZE_16BITS,
 	.tube_nr_xfers = 0, //set me
-	.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CIRC | DMA_CFG_HALF_CMPLT_IE | DMA_CFG_CMPLT_IE,
+	.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CMPLT_IE,
 	.target_data = NULL,
 	.tube_req_src = DMA_REQ_SRC_ADC3
 };
@@ -81,12 +81,164 @@ broadcast_address(uint8_t *brd, uint8_t *ip, uint8_t *subnet)
 	*brd32 = (*ip32 & *subnet32) | (~(*subnet32));
 }
 
+/*
+ * the chip places socket buffers back to back in socket order, memory is
+ * therefore only shared within groups of fixed total size, so that toggling
+ * a service never moves the buffers of the config socket
+ */
+typedef struct _Socket_Group Socket_Group;
+
+struct _Socket_Group {
+	uint8_t pool; // KB
+	uint8_t n;
+	uint8_t sock [5]; // by priority
+};
+
+static const Socket_Group socket_groups [] = {
+	{12, 5, {SOCK_OUTPUT, SOCK_DHCPC, SOCK_SNTP, SOCK_PTP_EV, SOCK_PTP_GE}},
+	{2, 1, {SOCK_CONFIG}},
+	{2, 2, {SOCK_DEBUG, SOCK_MDNS}}
+};
+
+static void (*const socket_enable [WIZ_MAX_SOCK_NUM])(uint8_t b) = {
+	[SOCK_DHCPC]	= dhcpc_enable,
+	[SOCK_SNTP]		= sntp_enable,
+	[SOCK_PTP_EV]	= ptp_enable,
+	[SOCK_PTP_GE]	= NULL, // reopened together with SOCK_PTP_EV
+	[SOCK_OUTPUT]	= output_enable,
+	[SOCK_CONFIG]	= config_enable,
+	[SOCK_DEBUG]	= debug_enable,
+	[SOCK_MDNS]		= mdns_enable
+};
+
+static uint8_t
+_sockets_enabled(uint_fast8_t arp)
+{
+	uint8_t enabled = 0;
+
+	if(arp || config.dhcpc.socket.enabled) // = SOCK_ARP, always needs memory
+		enabled |= 1U << SOCK_DHCPC;
+	if(config.sntp.socket.enabled)
+		enabled |= 1U << SOCK_SNTP;
+	if(config.ptp.event.enabled)
+		enabled |= (1U << SOCK_PTP_EV) | (1U << SOCK_PTP_GE);
+	if(config.output.osc.socket.enabled)
+		enabled |= 1U << SOCK_OUTPUT;
+	if(config.config.osc.socket.enabled)
+		enabled |= 1U << SOCK_CONFIG;
+	if(config.debug.osc.socket.enabled)
+		enabled |= 1U << SOCK_DEBUG;
+	if(config.mdns.socket.enabled)
+		enabled |= 1U << SOCK_MDNS;
+
+	return enabled;
+}
+
+static uint8_t
+_sockets_grow(uint8_t *mem, const Socket_Group *group, uint8_t pool, uint8_t mask)
+{
+	uint_fast8_t i;
+
+	// sizes must be powers of two, double each by priority as far as the pool allows
+	for(i=0; i<group->n; i++)
+	{
+		uint8_t sock = group->sock[i];
+		if(!(mask & (1U << sock)))
+			continue;
+		if(!mem[sock] && pool)
+		{
+			mem[sock] = 1;
+			pool -= 1;
+		}
+		while(mem[sock] && (mem[sock] <= pool) && (mem[sock] < 16) )
+		{
+			pool -= mem[sock];
+			mem[sock] <<= 1;
+		}
+	}
+
+	return pool;
+}
+
+void
+sockets_partition(uint8_t *tx_mem, uint8_t *rx_mem)
+{
+	uint8_t enabled = _sockets_enabled(1);
+	uint_fast8_t g, i;
+
+	for(g=0; g<sizeof(socket_groups)/sizeof(Socket_Group); g++)
+	{
+		const Socket_Group *group = &socket_groups[g];
+		uint8_t pool = group->pool;
+
+		// 1KB minimum for every enabled socket
+		for(i=0; i<group->n; i++)
+		{
+			uint8_t sock = group->sock[i];
+			tx_mem[sock] = enabled & (1U << sock) ? 1 : 0;
+			pool -= tx_mem[sock];
+		}
+
+		// hand the rest to enabled sockets, park what is left on disabled ones to keep the group size
+		pool = _sockets_grow(tx_mem, group, pool, enabled);
+		_sockets_grow(tx_mem, group, pool, ~enabled);
+	}
+
+	memcpy(rx_mem, tx_mem, WIZ_MAX_SOCK_NUM);
+}
+
+void
+sockets_repartition()
+{
+	uint8_t tx_old [WIZ_MAX_SOCK_NUM];
+	uint8_t rx_old [WIZ_MAX_SOCK_NUM];
+	uint8_t tx_mem [WIZ_MAX_SOCK_NUM];
+	uint8_t rx_mem [WIZ_MAX_SOCK_NUM];
+	uint8_t tx_base = 0, rx_base = 0, tx_base_old = 0, rx_base_old = 0;
+	uint8_t moved = 0;
+	uint_fast8_t sock;
+
+	wiz_sockets_get(tx_old, rx_old);
+	sockets_partition(tx_mem, rx_mem);
+
+	// a socket must be reopened when its buffer moved or was resized
+	for(sock=0; sock<WIZ_MAX_SOCK_NUM; sock++)
+	{
+		if( (tx_base != tx_base_old) || (rx_base != rx_base_old)
+				|| (tx_mem[sock] != tx_old[sock]) || (rx_mem[sock] != rx_old[sock]) )
+			moved |= 1U << sock;
+		tx_base += tx_mem[sock];
+		rx_base += rx_mem[sock];
+		tx_base_old += tx_old[sock];
+		rx_base_old += rx_old[sock];
+	}
+
+	if(!moved)
+		return;
+
+	for(sock=0; sock<WIZ_MAX_SOCK_NUM; sock++)
+		if(moved & (1U << sock))
+			udp_end(sock); // closes TCP sockets, too
+
+	wiz_sockets_set(tx_mem, rx_mem);
+
+	// layout is current now, the enable calls below will not recurse further
+	uint8_t enabled = _sockets_enabled(0);
+	if(moved & (1U << SOCK_PTP_GE))
+		moved |= 1U << SOCK_PTP_EV;
+	for(sock=0; sock<WIZ_MAX_SOCK_NUM; sock++)
+		if( (moved & enabled & (1U << sock)) && socket_enable[sock])
+			socket_enable[sock](1);
+}
+
 void 
 output_enable(uint8_t b)
 {
 	Socket_Config *socket = &config.output.osc.socket;
 
 	socket->enabled = b;
+	sockets_repartition();
+	output_batch_reset(1); // TX memory of the socket is reset
 
 	if(!config.output.osc.mode)
 	{
@@ -115,6 +267,7 @@ config_enable(uint8_t b)
 	Socket_Config *socket = &config.config.osc.socket;
 
 	socket->enabled = b;
+	sockets_repartition();
 
 	if(!config.config.osc.mode)
 	{
@@ -147,6 +300,8 @@ ptp_enable(uint8_t b)
 
 	event->enabled = b;
 	general->enabled = b;
+	sockets_repartition();
+	output_irq_update();
 	udp_end(event->sock);
 	udp_end(general->sock);
 
@@ -173,6 +328,8 @@ sntp_enable(uint8_t b)
 	sync_timer_reconfigure();
 
 	socket->enabled = b;
+	sockets_repartition();
+	output_irq_update();
 	udp_end(socket->sock);
 
 	if(socket->enabled)
@@ -193,6 +350,7 @@ debug_enable(uint8_t b)
 	Socket_Config *socket = &config.debug.osc.socket;
 
 	socket->enabled = b;
+	sockets_repartition();
 
 	if(!config.debug.osc.mode)
 	{
@@ -220,6 +378,7 @@ mdns_enable(uint8_t b)
 	Socket_Config *socket = &config.mdns.socket;
 
 	socket->enabled = b;
+	sockets_repartition();
 	udp_end(socket->sock);
 
 	if(socket->enabled)
@@ -53,8 +53,8 @@ static const uint16_t SOCK_OFFSET [WIZ_MAX_SOCK_NUM] = {
 inline __always_inline void
 wiz_job_set_frame()
 {
-	Wiz_Job *job = &wiz_jobs[wiz_jobs_done];
-	uint8_t *frm_tx = job->tx - WIZ_SEND_OFFSET;
+	Wiz_Job *job = &wiz_jobs[wiz_jobs_tail];
+	uint8_t *frm_tx = job->rw == WIZ_TXV ? job->hdr : job->tx - WIZ_SEND_OFFSET;
 
 	frm_tx[0] = job->addr >> 8;
 	frm_tx[1] = job->addr & 0xFF;
@@ -69,6 +69,13 @@ _dma_write_sock(uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len)
 	_dma_write(SOCK_OFFSET[sock] + addr, 0, dat, len);
 }
 
+inline __always_inline void
+_burst_write_sock(Wiz_Burst *burst, uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len)
+{
+	// transform relative socket registry address to absolute registry address
+	wiz_burst_write(burst, SOCK_OFFSET[sock] + addr, 0, dat, len);
+}
+
 inline __always_inline void
 _dma_read_sock(uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len)
 {
@@ -93,6 +100,14 @@ wiz_sockets_set(uint8_t tx_mem[WIZ_MAX_SOCK_NUM], uint8_t rx_mem[WIZ_MAX_SOCK_NU
 		else
 			SBASE[sock] = TX_BUF_BASE;
 
+		// sizes only change on reconfiguration
+		Wiz_Shadow *shadow = &wiz_shadow[sock];
+		if( (shadow->valid & WIZ_SHADOW_BUF) && (shadow->tx_mem == tx_mem[sock]) && (shadow->rx_mem == rx_mem[sock]) )
+			continue;
+		shadow->tx_mem = tx_mem[sock];
+		shadow->rx_mem = rx_mem[sock];
+		shadow->valid |= WIZ_SHADOW_BUF;
+
 		flag = tx_mem[sock];
 		if(flag == 0x10)
 			flag = 0x0f; // special case
@@ -210,6 +225,9 @@ udp_send_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len)
 	if( (len == 0) || (len > CHIMAERA_BUFSIZE - 2*WIZ_SEND_OFFSET - 3) )
 		return 0;
 
+	// a socket can only have one SEND in flight
+	udp_send_wait(sock);
+
 	uint8_t *tmp_buf_o = o_buf + WIZ_SEND_OFFSET;
 
 	uint16_t ptr = Sn_Tx_WR[sock];
@@ -237,6 +255,143 @@ udp_send_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len)
 	flag[2] = WIZ_Sn_CR_SEND;
 	wiz_job_add(SOCK_OFFSET[sock] + WIZ_Sn_CR, 1, &flag[2], NULL, 0, WIZ_TX);
 
+	// completion of SEND will be signaled via socket IRQ
+	if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+		wiz_send_pending[sock] = 1;
+
+	wiz_job_run_nonblocking();
+
+	return 1;
+}
+
+void __CCM_TEXT__
+_udp_send_cmd(uint8_t sock, uint16_t ptr)
+{
+	// only reused after SEND_OK, by then the previous jobs have long run
+	static uint8_t flags [WIZ_MAX_SOCK_NUM][3];
+	uint8_t *flag = flags[sock];
+
+	flag[0] = ptr >> 8;
+	flag[1] = ptr & 0xFF;
+	const Wiz_Vec wr = {&flag[0], 2};
+	wiz_job_add_sg(SOCK_OFFSET[sock] + WIZ_Sn_TX_WR, &wr, 1, 0);
+
+	// send data
+	flag[2] = WIZ_Sn_CR_SEND;
+	const Wiz_Vec cr = {&flag[2], 1};
+	wiz_job_add_sg(SOCK_OFFSET[sock] + WIZ_Sn_CR, &cr, 1, 0);
+
+	// completion of SEND will be signaled via socket IRQ
+	if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+		wiz_send_pending[sock] = 1;
+}
+
+uint_fast8_t __CCM_TEXT__
+udp_sendv_nonblocking(uint8_t sock, const Wiz_Vec *vec, uint_fast8_t n)
+{
+	Wiz_Vec lo [WIZ_MAX_VEC_NUM];
+	Wiz_Vec hi [WIZ_MAX_VEC_NUM];
+	uint_fast8_t lo_n = 0;
+	uint_fast8_t hi_n = 0;
+	uint16_t len = 0;
+	uint_fast8_t i;
+
+	for(i=0; i<n; i++)
+		len += vec[i].len;
+	if( (len == 0) || (n > WIZ_MAX_VEC_NUM) )
+		return 0;
+
+	// a socket can only have one SEND in flight
+	udp_send_wait(sock);
+
+	uint16_t ptr = Sn_Tx_WR[sock];
+  uint16_t offset = ptr & SMASK[sock];
+  uint16_t dstAddr = offset + SBASE[sock];
+
+	// split the segments at the end of the TX buffer
+	uint16_t size = SSIZE[sock] - offset;
+	for(i=0; i<n; i++)
+	{
+		if(size >= vec[i].len)
+		{
+			lo[lo_n++] = vec[i];
+			size -= vec[i].len;
+		}
+		else
+		{
+			if(size)
+			{
+				lo[lo_n].buf = vec[i].buf;
+				lo[lo_n++].len = size;
+			}
+			hi[hi_n].buf = vec[i].buf + size;
+			hi[hi_n++].len = vec[i].len - size;
+			size = 0;
+		}
+	}
+
+	if(lo_n)
+		wiz_job_add_sg(dstAddr, lo, lo_n, 0);
+	if(hi_n)
+		wiz_job_add_sg(SBASE[sock], hi, hi_n, 0);
+
+  ptr += len;
+	Sn_Tx_WR[sock] = ptr;
+
+	_udp_send_cmd(sock, ptr);
+
+	wiz_job_run_nonblocking();
+
+	return 1;
+}
+
+uint_fast8_t  __CCM_TEXT__
+udp_append_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len, uint_fast8_t send)
+{
+	if( ( (len == 0) && !send) || (len > CHIMAERA_BUFSIZE - 2*WIZ_SEND_OFFSET - 3) )
+		return 0;
+
+	// a socket can only have one SEND in flight
+	if(send)
+		udp_send_wait(sock);
+
+	uint8_t *tmp_buf_o = o_buf + WIZ_SEND_OFFSET;
+
+	uint16_t ptr = Sn_Tx_WR[sock];
+  uint16_t offset = ptr & SMASK[sock];
+  uint16_t dstAddr = offset + SBASE[sock];
+
+	// data beyond Sn_TX_WR is not touched by an in-flight SEND
+	if(len == 0)
+		;
+  else if( (offset + len) > SSIZE[sock]) 
+  {
+    uint16_t size = SSIZE[sock] - offset;
+		wiz_job_add(dstAddr, size, tmp_buf_o, NULL, 0, WIZ_TX);
+		wiz_job_add(SBASE[sock], len-size, tmp_buf_o+size, NULL, 0, WIZ_TX);
+  } 
+  else
+		wiz_job_add(dstAddr, len, tmp_buf_o, NULL, 0, WIZ_TX);
+
+  ptr += len;
+	Sn_Tx_WR[sock] = ptr;
+
+	if(send)
+	{
+		uint8_t *flag = tmp_buf_o+len;
+		flag[0] = ptr >> 8;
+		flag[1] = ptr & 0xFF;
+		wiz_job_add(SOCK_OFFSET[sock] + WIZ_Sn_TX_WR, 2, &flag[0], NULL, 0, WIZ_TX);
+
+		// send everything appended since the last SEND as a single datagram
+		flag[2] = WIZ_Sn_CR_SEND;
+		wiz_job_add(SOCK_OFFSET[sock] + WIZ_Sn_CR, 1, &flag[2], NULL, 0, WIZ_TX);
+
+		// completion of SEND will be signaled via socket IRQ
+		if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+			wiz_send_pending[sock] = 1;
+	}
+
 	wiz_job_run_nonblocking();
 
 	return 1;
@@ -54,8 +54,8 @@ static const W5500_Socket_Sel W5500_socket_sel [8] = {
 inline __always_inline void
 wiz_job_set_frame()
 {
-	Wiz_Job *job = &wiz_jobs[wiz_jobs_done];
-	uint8_t *frm_tx = job->tx - WIZ_SEND_OFFSET;
+	Wiz_Job *job = &wiz_jobs[wiz_jobs_tail];
+	uint8_t *frm_tx = job->rw == WIZ_TXV ? job->hdr : job->tx - WIZ_SEND_OFFSET;
 
 	frm_tx[0] = job->addr >> 8;
 	frm_tx[1] = job->addr & 0xFF;
@@ -69,6 +69,12 @@ _dma_write_sock(uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len)
 	_dma_write(addr, W5500_socket_sel[sock].reg, dat, len);
 }
 
+inline __always_inline void
+_burst_write_sock(Wiz_Burst *burst, uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len)
+{
+	wiz_burst_write(burst, addr, W5500_socket_sel[sock].reg, dat, len);
+}
+
 inline __always_inline void
 _dma_read_sock(uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len)
 {
@@ -85,13 +91,22 @@ wiz_sockets_set(uint8_t tx_mem[WIZ_MAX_SOCK_NUM], uint8_t rx_mem[WIZ_MAX_SOCK_NU
 	// initialize all socket memory TX and RX sizes to their corresponding sizes
   for(sock=0; sock<WIZ_MAX_SOCK_NUM; sock++)
 	{
-		// initialize tx registers
 		SSIZE[sock] =(uint16_t)tx_mem[sock] * 0x0400;
+		RSIZE[sock] =(uint16_t)rx_mem[sock] * 0x0400;
+
+		// sizes only change on reconfiguration
+		Wiz_Shadow *shadow = &wiz_shadow[sock];
+		if( (shadow->valid & WIZ_SHADOW_BUF) && (shadow->tx_mem == tx_mem[sock]) && (shadow->rx_mem == rx_mem[sock]) )
+			continue;
+		shadow->tx_mem = tx_mem[sock];
+		shadow->rx_mem = rx_mem[sock];
+		shadow->valid |= WIZ_SHADOW_BUF;
+
+		// initialize tx registers
 		flag = tx_mem[sock];
 		_dma_write_sock(sock, WIZ_Sn_TXBUF_SIZE, &flag, 1); // TX_MEMSIZE
 
 		// initialize rx registers
-		RSIZE[sock] =(uint16_t)rx_mem[sock] * 0x0400;
 		flag = rx_mem[sock];
 		_dma_write_sock(sock, WIZ_Sn_RXBUF_SIZE, &flag, 1); // RX_MEMSIZE
   }
@@ -172,6 +187,9 @@ udp_send_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len)
 	if( (len == 0) || (len > CHIMAERA_BUFSIZE + WIZ_SEND_OFFSET + 3) )
 		return 0;
 
+	// a socket can only have one SEND in flight
+	udp_send_wait(sock);
+
 	uint8_t *tmp_buf_o = o_buf + WIZ_SEND_OFFSET;
 
 	uint16_t ptr = Sn_Tx_WR[sock];
@@ -190,6 +208,103 @@ udp_send_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len)
 	flag[2] = WIZ_Sn_CR_SEND;
 	wiz_job_add(WIZ_Sn_CR, 1, &flag[2], NULL, W5500_socket_sel[sock].reg, WIZ_TX);
 
+	// completion of SEND will be signaled via socket IRQ
+	if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+		wiz_send_pending[sock] = 1;
+
+	wiz_job_run_nonblocking();
+
+	return 1;
+}
+
+void __CCM_TEXT__
+_udp_send_cmd(uint8_t sock, uint16_t ptr)
+{
+	// only reused after SEND_OK, by then the previous jobs have long run
+	static uint8_t flags [WIZ_MAX_SOCK_NUM][3];
+	uint8_t *flag = flags[sock];
+
+	flag[0] = ptr >> 8;
+	flag[1] = ptr & 0xFF;
+	const Wiz_Vec wr = {&flag[0], 2};
+	wiz_job_add_sg(WIZ_Sn_TX_WR, &wr, 1, W5500_socket_sel[sock].reg);
+
+	// send data
+	flag[2] = WIZ_Sn_CR_SEND;
+	const Wiz_Vec cr = {&flag[2], 1};
+	wiz_job_add_sg(WIZ_Sn_CR, &cr, 1, W5500_socket_sel[sock].reg);
+
+	// completion of SEND will be signaled via socket IRQ
+	if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+		wiz_send_pending[sock] = 1;
+}
+
+uint_fast8_t __CCM_TEXT__
+udp_sendv_nonblocking(uint8_t sock, const Wiz_Vec *vec, uint_fast8_t n)
+{
+	uint16_t len = 0;
+	uint_fast8_t i;
+
+	for(i=0; i<n; i++)
+		len += vec[i].len;
+	if( (len == 0) || (n > WIZ_MAX_VEC_NUM) )
+		return 0;
+
+	// a socket can only have one SEND in flight
+	udp_send_wait(sock);
+
+	uint16_t ptr = Sn_Tx_WR[sock];
+
+	// all segments under a single chip select, the W5500 wraps the TX buffer by itself
+	wiz_job_add_sg(ptr, vec, n, W5500_socket_sel[sock].tx_buf);
+
+	ptr += len;
+	Sn_Tx_WR[sock] = ptr;
+
+	_udp_send_cmd(sock, ptr);
+
+	wiz_job_run_nonblocking();
+
+	return 1;
+}
+
+uint_fast8_t  __CCM_TEXT__
+udp_append_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len, uint_fast8_t send)
+{
+	if( ( (len == 0) && !send) || (len > CHIMAERA_BUFSIZE + WIZ_SEND_OFFSET + 3) )
+		return 0;
+
+	// a socket can only have one SEND in flight
+	if(send)
+		udp_send_wait(sock);
+
+	uint8_t *tmp_buf_o = o_buf + WIZ_SEND_OFFSET;
+
+	uint16_t ptr = Sn_Tx_WR[sock];
+
+	// data beyond Sn_TX_WR is not touched by an in-flight SEND
+	if(len)
+		wiz_job_add(ptr, len, tmp_buf_o, NULL, W5500_socket_sel[sock].tx_buf, WIZ_TX);
+
+  ptr += len;
+	Sn_Tx_WR[sock] = ptr;
+
+	if(send)
+	{
+		uint8_t *flag = tmp_buf_o+len;
+		flag[0] = ptr >> 8;
+		flag[1] = ptr & 0xFF;
+		wiz_job_add(WIZ_Sn_TX_WR, 2, &flag[0], NULL, W5500_socket_sel[sock].reg, WIZ_TX);
+
+		// send everything appended since the last SEND as a single datagram
+		flag[2] = WIZ_Sn_CR_SEND;
+		wiz_job_add(WIZ_Sn_CR, 1, &flag[2], NULL, W5500_socket_sel[sock].reg, WIZ_TX);
+
+		// completion of SEND will be signaled via socket IRQ
+		if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+			wiz_send_pending[sock] = 1;
+	}
+
 	wiz_job_run_nonblocking();
 
 	return 1;
@@ -32,13 +32,16 @@
 #include <tube.h>
 #include <netdef.h>
 #include <oscpod.h>
+#include <sntp.h>
+#include <utility.h>
 
 #include <libmaple/dma.h>
 #include <libmaple/spi.h>
 
 Wiz_Job wiz_jobs [WIZ_MAX_JOB_NUM];
-volatile uint_fast8_t wiz_jobs_todo = 0;
-volatile uint_fast8_t wiz_jobs_done;
+volatile uint_fast8_t wiz_jobs_head = 0;
+volatile uint_fast8_t wiz_jobs_tail = 0;
+volatile uint_fast8_t wiz_jobs_busy = 0;
 
 const uint8_t wiz_broadcast_ip [] = {0xff, 0xff, 0xff, 0xff};
 const uint8_t wiz_nil_ip [] = {0x00, 0x00, 0x00, 0x00};
@@ -52,10 +55,37 @@ uint8_t ss_bit;
 
 Wiz_IRQ_Cb irq_cb = NULL;
 Wiz_IRQ_Cb irq_socket_cb [WIZ_MAX_SOCK_NUM];
+uint8_t irq_socket_mask [WIZ_MAX_SOCK_NUM];
+
+volatile uint_fast8_t wiz_send_pending [WIZ_MAX_SOCK_NUM];
 
 uint16_t SSIZE [WIZ_MAX_SOCK_NUM];
 uint16_t RSIZE [WIZ_MAX_SOCK_NUM];
 
+volatile Wiz_SPI_Stats wiz_spi_stats;
+
+static uint32_t spi_frame_t0; // core cycles when chip select was asserted
+static uint_fast8_t spi_adapt = 0;
+static uint16_t spi_br = WIZ_SPI_BR_FAST;
+static uint16_t spi_err_burst = 0;
+static uint16_t spi_clean = 0;
+
+uint8_t wiz_imr_shadow = 0;
+uint8_t wiz_simr_shadow = 0;
+Wiz_Shadow wiz_shadow [WIZ_MAX_SOCK_NUM];
+
+// Sn_TX_WR at the end of each datagram queued in socket TX memory, tail is in flight
+static uint16_t send_queue [WIZ_MAX_SOCK_NUM][WIZ_SEND_QUEUE_NUM];
+static uint_fast8_t send_queue_head [WIZ_MAX_SOCK_NUM];
+static uint_fast8_t send_queue_tail [WIZ_MAX_SOCK_NUM];
+static uint16_t send_queue_base [WIZ_MAX_SOCK_NUM]; // TX memory before this is free
+
+// bumped whenever a socket is closed, dispatchers use it to notice callbacks touching their socket
+static uint8_t socket_gen [WIZ_MAX_SOCK_NUM];
+
+// rest of an oversized framed TCP packet still to be skipped, belongs to the current connection only
+static uint32_t tcp_drop [WIZ_MAX_SOCK_NUM];
+
 uint16_t Sn_Tx_WR[WIZ_MAX_SOCK_NUM];
 uint16_t Sn_Rx_RD[WIZ_MAX_SOCK_NUM];
 
@@ -65,11 +95,9 @@ uint8_t buf_i2 [WIZ_SEND_OFFSET + 6] __attribute__((aligned(4)));
 inline __always_inline void
 _dma_write(uint16_t addr, uint8_t cntrl, uint8_t *dat, uint16_t len)
 {
-	uint8_t *tmp_buf_o = buf_o2 + WIZ_SEND_OFFSET;
-	
-	memcpy(tmp_buf_o, dat, len);
+	const Wiz_Vec vec = {dat, len}; // straight from the caller, no staging copy
 
-	wiz_job_add(addr, len, tmp_buf_o, NULL, cntrl, WIZ_TX);
+	wiz_job_add_sg(addr, &vec, 1, cntrl);
 
 	wiz_job_run_nonblocking();
 	wiz_job_run_block();
@@ -104,10 +132,141 @@ _dma_read_sock_16(int8_t sock, uint16_t addr, uint16_t *dat)
 	*dat = ntoh(*dat);
 }
 
+void
+wiz_burst_write(Wiz_Burst *burst, uint16_t addr, uint8_t cntrl, uint8_t *dat, uint16_t len)
+{
+	// start a new frame when not contiguous with the pending one
+	if(burst->len && ( (cntrl != burst->cntrl) || (addr != burst->addr + burst->len)
+			|| (burst->len + len > WIZ_BURST_MAX) ) )
+		wiz_burst_flush(burst);
+
+	if(!burst->len)
+	{
+		burst->addr = addr;
+		burst->cntrl = cntrl;
+	}
+
+	memcpy(burst->buf + burst->len, dat, len);
+	burst->len += len;
+}
+
+void
+wiz_burst_flush(Wiz_Burst *burst)
+{
+	if(!burst->len)
+		return;
+
+	_dma_write(burst->addr, burst->cntrl, burst->buf, burst->len);
+	burst->len = 0;
+}
+
+inline __always_inline void
+_burst_write_sock_16(Wiz_Burst *burst, uint8_t sock, uint16_t addr, uint16_t dat)
+{
+	uint16_t _dat = hton(dat);
+	_burst_write_sock(burst, sock, addr, (uint8_t *)&_dat, 2);
+}
+
+static inline __always_inline uint32_t
+_wiz_cycles()
+{
+	uint32_t cycles;
+	uint32_t ticks = sntp_uptime_cycles(&cycles);
+
+	return ticks*SNTP_SYSTICK_CYCLES + cycles; // wraps, only differences count
+}
+
+static inline __always_inline void
+_wiz_frame_begin()
+{
+	setSS();
+	spi_frame_t0 = _wiz_cycles();
+}
+
+static inline __always_inline void
+_wiz_frame_end()
+{
+	resetSS();
+	wiz_spi_stats.cycles += _wiz_cycles() - spi_frame_t0;
+}
+
+// only between frames, BR must not change while a frame is clocked
+static void
+_wiz_spi_br_set(uint16_t br)
+{
+	spi_br = br;
+	WIZ_SPI_BAS->CR1 = (WIZ_SPI_BAS->CR1 & ~SPI_CR1_BR) | br;
+}
+
+static void __CCM_TEXT__
+_wiz_spi_error(uint8_t isr_rx, uint8_t isr_tx, uint8_t spi_sr)
+{
+	if(isr_rx & DMA_ISR_TEIF)
+		wiz_spi_stats.dma_err++;
+	if(isr_tx & DMA_ISR_TEIF)
+		wiz_spi_stats.dma_err++;
+	if(spi_sr & SPI_SR_MODF)
+	{
+		wiz_spi_stats.modf++;
+
+		// cleared by the SR read in the ISR followed by a CR1 write, which also restores master mode
+		WIZ_SPI_BAS->CR1 |= SPI_CR1_MSTR | SPI_CR1_SPE;
+	}
+	if(spi_sr & SPI_SR_OVR)
+	{
+		wiz_spi_stats.ovr++;
+
+		// clear it, else the retry fails on the stale flag
+		spi_sr = spi_rx_reg(WIZ_SPI_DEV);
+		spi_sr = WIZ_SPI_BAS->SR;
+	}
+
+	spi_clean = 0;
+	if(spi_adapt && (++spi_err_burst >= WIZ_SPI_ERR_BURST) )
+	{
+		spi_err_burst = 0;
+		if(spi_br < WIZ_SPI_BR_SLOW)
+			_wiz_spi_br_set(spi_br + WIZ_SPI_BR_STEP);
+	}
+}
+
+// retry a failed job from its start, give up on persistent errors
+static inline __always_inline void
+_wiz_job_error(Wiz_Job *job)
+{
+	job->rx_hdr_sent = 0;
+	job->vec_i = 0;
+
+	if(++job->retry >= WIZ_JOB_RETRY_MAX)
+	{
+		wiz_jobs_tail = (wiz_jobs_tail + 1) & WIZ_JOB_MASK;
+		wiz_spi_stats.dropped++;
+	}
+}
+
+static inline __always_inline void
+_wiz_spi_done()
+{
+	wiz_spi_stats.frames++;
+
+	if(!spi_adapt)
+		return;
+
+	spi_clean++;
+	if(spi_clean == WIZ_SPI_ERR_WINDOW) // errors this far apart are no burst
+		spi_err_burst = 0;
+	else if(spi_clean == WIZ_SPI_CLEAN_RUN)
+	{
+		spi_clean = 0;
+		if(spi_br > WIZ_SPI_BR_FAST)
+			_wiz_spi_br_set(spi_br - WIZ_SPI_BR_STEP);
+	}
+}
+
 static void __CCM_TEXT__
 _wiz_rx_irq()
 {
-	Wiz_Job *job = &wiz_jobs[wiz_jobs_done];
+	Wiz_Job *job = &wiz_jobs[wiz_jobs_tail];
 	uint8_t isr_rx = dma_get_isr_bits(WIZ_SPI_RX_DMA_DEV, WIZ_SPI_RX_DMA_TUB);
 	uint8_t isr_tx = dma_get_isr_bits(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB);
 	uint8_t spi_sr = WIZ_SPI_BAS->SR;
@@ -132,25 +291,34 @@ _wiz_rx_irq()
 	{
 		if( (job->rw & WIZ_TX) || job->rx_hdr_sent)
 		{
-			wiz_jobs_done++;
-			resetSS();
+			wiz_jobs_tail = (wiz_jobs_tail + 1) & WIZ_JOB_MASK;
+			_wiz_frame_end();
+			_wiz_spi_done();
 		}
 		else
 			job->rx_hdr_sent = 1;
 	}
 	else
-		resetSS();
+	{
+		_wiz_frame_end();
+		if(rx_err)
+		{
+			_wiz_spi_error(isr_rx, isr_tx, spi_sr);
+			_wiz_job_error(job);
+		}
+	}
 
-	if(wiz_jobs_done < wiz_jobs_todo)
+	// chain the next job, the main loop may have appended meanwhile
+	if(wiz_jobs_tail != wiz_jobs_head)
 		wiz_job_run_single();
 	else
-		wiz_jobs_todo = 0;
+		wiz_jobs_busy = 0;
 }
 
 static void __CCM_TEXT__
 _wiz_tx_irq()
 {
-	Wiz_Job *job = &wiz_jobs[wiz_jobs_done];
+	Wiz_Job *job = &wiz_jobs[wiz_jobs_tail];
 	uint8_t isr_tx = dma_get_isr_bits(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB);
 	uint8_t spi_sr = WIZ_SPI_BAS->SR;
 	uint_fast8_t tx_err = 0;
@@ -165,6 +333,14 @@ _wiz_tx_irq()
 	dma_clear_isr_bits(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB);
 	dma_disable(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB); // Tx
 
+	if( !tx_err && (isr_tx & DMA_ISR_TCIF) && (job->rw == WIZ_TXV) && (job->vec_i < job->vec_n) )
+	{
+		// next segment under the same chip select, the TX FIFO needs no draining in between
+		job->vec_i++;
+		wiz_job_run_single();
+		return;
+	}
+
 	if( !tx_err && (isr_tx & DMA_ISR_TCIF) ) // no error and Tx DMA transfer complete
 	{
 		do {
@@ -181,21 +357,37 @@ _wiz_tx_irq()
 			spi_sr = WIZ_SPI_BAS->SR;
 		} while( (spi_sr & SPI_SR_FRLVL) || (spi_sr & SPI_SR_RXNE) || (spi_sr & SPI_SR_OVR) ); // empty buffer and clear OVR flag
 
-		wiz_jobs_done++;
+		wiz_jobs_tail = (wiz_jobs_tail + 1) & WIZ_JOB_MASK;
+		_wiz_frame_end();
+		_wiz_spi_done();
+	}
+	else
+	{
+		_wiz_frame_end();
+		if(tx_err)
+		{
+			_wiz_spi_error(0, isr_tx, spi_sr);
+			_wiz_job_error(job);
+		}
 	}
 
-	resetSS();
-
-	if(wiz_jobs_done < wiz_jobs_todo)
+	// chain the next job, the main loop may have appended meanwhile
+	if(wiz_jobs_tail != wiz_jobs_head)
 		wiz_job_run_single();
 	else
-		wiz_jobs_todo = 0;
+		wiz_jobs_busy = 0;
 }
 
 void __CCM_TEXT__
 wiz_job_add(uint16_t addr, uint16_t len, uint8_t *tx, uint8_t *rx, uint8_t opmode, uint8_t rw)
 {
-	Wiz_Job *job = &wiz_jobs[wiz_jobs_todo];
+	const uint_fast8_t head = wiz_jobs_head;
+	const uint_fast8_t next = (head + 1) & WIZ_JOB_MASK;
+
+	while(next == wiz_jobs_tail) // ring full, let the DMA chain drain it
+		wiz_job_run_nonblocking();
+
+	Wiz_Job *job = &wiz_jobs[head];
 	job->addr = addr;
 	job->len = len;
 	job->tx = tx;
@@ -203,8 +395,42 @@ wiz_job_add(uint16_t addr, uint16_t len, uint8_t *tx, uint8_t *rx, uint8_t opmod
 	job->opmode = opmode;
 	job->rw = rw;
 	job->rx_hdr_sent = 0;
+	job->retry = 0;
 
-	wiz_jobs_todo++;
+	wiz_dmb();
+	wiz_jobs_head = next;
+}
+
+void __CCM_TEXT__
+wiz_job_add_sg(uint16_t addr, const Wiz_Vec *vec, uint_fast8_t n, uint8_t opmode)
+{
+	const uint_fast8_t head = wiz_jobs_head;
+	const uint_fast8_t next = (head + 1) & WIZ_JOB_MASK;
+	uint_fast8_t i;
+
+	while(next == wiz_jobs_tail) // ring full, let the DMA chain drain it
+		wiz_job_run_nonblocking();
+
+	Wiz_Job *job = &wiz_jobs[head];
+	job->addr = addr;
+	job->len = 0;
+	job->tx = NULL;
+	job->rx = NULL;
+	job->opmode = opmode;
+	job->rw = WIZ_TXV;
+	job->rx_hdr_sent = 0;
+	job->retry = 0;
+	job->vec_n = 0;
+	job->vec_i = 0;
+	for(i=0; (i<n) && (job->vec_n<WIZ_MAX_VEC_NUM); i++)
+		if(vec[i].len) // empty segments would never raise a DMA IRQ
+		{
+			job->vec[job->vec_n++] = vec[i];
+			job->len += vec[i].len;
+		}
+
+	wiz_dmb();
+	wiz_jobs_head = next;
 }
 
 void __CCM_TEXT__
@@ -214,7 +440,7 @@ wiz_job_run_single()
 	uint8_t *frm_rx = NULL;
 	uint8_t *frm_tx = NULL;
 	uint16_t len2;
-	Wiz_Job *job = &wiz_jobs[wiz_jobs_done];
+	Wiz_Job *job = &wiz_jobs[wiz_jobs_tail];
 
 	switch(job->rw)
 	{
@@ -229,11 +455,45 @@ wiz_job_run_single()
 			spi_rx_dma_disable(WIZ_SPI_DEV); // disable RX DMA on WIZ_SPI_DEV
 
 			wiz_job_set_frame();
-			setSS();
+			_wiz_frame_begin();
 
 			len2 = job->len + WIZ_SEND_OFFSET;
 
 			frm_tx = job->tx - WIZ_SEND_OFFSET;
+			wiz_spi_stats.bytes += len2; // before the ISRs can chain the next one
+			spi_tx_dma_enable(WIZ_SPI_DEV); // enable TX DMA on WIZ_SPI_DEV
+			spi_tx_tube.tube_src = frm_tx;
+			dma_set_mem_addr(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB, spi_tx_tube.tube_src);
+			dma_set_num_transfers(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB, len2); // Tx
+			dma_enable(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB); // Tx
+
+			break;
+
+		case WIZ_TXV:
+			if(job->vec_i == 0) // header
+			{
+				dma_channel_regs(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB)->CCR |= DMA_CCR_TCIE | DMA_CCR_TEIE;
+				dma_attach_interrupt(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB, _wiz_tx_irq);
+
+				dma_channel_regs(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB)->CCR |= DMA_CCR_MINC;
+
+				dma_detach_interrupt(WIZ_SPI_RX_DMA_DEV, WIZ_SPI_RX_DMA_TUB);
+
+				spi_rx_dma_disable(WIZ_SPI_DEV); // disable RX DMA on WIZ_SPI_DEV
+
+				wiz_job_set_frame();
+				_wiz_frame_begin();
+
+				frm_tx = job->hdr;
+				len2 = WIZ_SEND_OFFSET;
+			}
+			else // segment, SS is already set
+			{
+				frm_tx = job->vec[job->vec_i - 1].buf;
+				len2 = job->vec[job->vec_i - 1].len;
+			}
+
+			wiz_spi_stats.bytes += len2;
 			spi_tx_dma_enable(WIZ_SPI_DEV); // enable TX DMA on WIZ_SPI_DEV
 			spi_tx_tube.tube_src = frm_tx;
 			dma_set_mem_addr(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB, spi_tx_tube.tube_src);
@@ -251,7 +511,7 @@ wiz_job_run_single()
 			if(!job->rx_hdr_sent)
 			{
 				wiz_job_set_frame();
-				setSS();
+				_wiz_frame_begin();
 
 				dma_channel_regs(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB)->CCR |= DMA_CCR_MINC;
 				frm_tx = job->tx - WIZ_SEND_OFFSET;
@@ -281,6 +541,7 @@ wiz_job_run_single()
 			dma_set_num_transfers(WIZ_SPI_RX_DMA_DEV, WIZ_SPI_RX_DMA_TUB, len2); // Rx
 			dma_enable(WIZ_SPI_RX_DMA_DEV, WIZ_SPI_RX_DMA_TUB); // Rx
 
+			wiz_spi_stats.bytes += len2;
 			spi_tx_dma_enable(WIZ_SPI_DEV); // enable TX DMA on WIZ_SPI_DEV
 			spi_tx_tube.tube_src = frm_tx;
 			dma_set_mem_addr(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB, spi_tx_tube.tube_src);
@@ -298,7 +559,7 @@ wiz_job_run_single()
 			dma_detach_interrupt(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB);
 			
 			wiz_job_set_frame();
-			setSS();
+			_wiz_frame_begin();
 
 			len2 = job->len + WIZ_SEND_OFFSET;
 
@@ -310,6 +571,7 @@ wiz_job_run_single()
 			dma_enable(WIZ_SPI_RX_DMA_DEV, WIZ_SPI_RX_DMA_TUB); // Rx
 
 			frm_tx = job->tx - WIZ_SEND_OFFSET;
+			wiz_spi_stats.bytes += len2;
 			spi_tx_dma_enable(WIZ_SPI_DEV); // enable TX DMA on WIZ_SPI_DEV
 			spi_tx_tube.tube_src = frm_tx;
 			dma_set_mem_addr(WIZ_SPI_TX_DMA_DEV, WIZ_SPI_TX_DMA_TUB, spi_tx_tube.tube_src);
@@ -323,15 +585,23 @@ wiz_job_run_single()
 inline __always_inline void
 wiz_job_run_nonblocking()
 {
-	wiz_jobs_done = 0;
-	if(wiz_jobs_done < wiz_jobs_todo)
+	/*
+	 * a running chain picks up appended jobs by itself, as the ISRs run
+	 * atomically with respect to the main loop, either they see the new head
+	 * or they have cleared busy before it is checked here
+	 */
+	if(!wiz_jobs_busy && (wiz_jobs_tail != wiz_jobs_head) )
+	{
+		wiz_jobs_busy = 1;
 		wiz_job_run_single();
+	}
 }
 
 inline __always_inline void
 wiz_job_run_block()
 {
-	while(wiz_jobs_todo)
+	wiz_job_run_nonblocking();
+	while(wiz_jobs_busy)
 		; // wait until all jobs are done
 }
 
@@ -369,6 +639,62 @@ wiz_init(gpio_dev *dev, uint8_t bit)
 	do {
 		_dma_read(WIZ_MR, 0, &flag, 1);
 	} while(flag & WIZ_MR_RST);
+
+	wiz_shadow_invalidate();
+}
+
+void
+wiz_shadow_invalidate()
+{
+	uint_fast8_t sock;
+
+	// IMR and SIMR are known to be cleared after a reset
+	wiz_imr_shadow = 0;
+	wiz_simr_shadow = 0;
+
+	for(sock=0; sock<WIZ_MAX_SOCK_NUM; sock++)
+		wiz_shadow[sock].valid = 0;
+}
+
+void
+wiz_sockets_get(uint8_t tx_mem[WIZ_MAX_SOCK_NUM], uint8_t rx_mem[WIZ_MAX_SOCK_NUM])
+{
+	uint_fast8_t sock;
+
+	// in KB, as given to wiz_sockets_set
+	for(sock=0; sock<WIZ_MAX_SOCK_NUM; sock++)
+	{
+		tx_mem[sock] = SSIZE[sock] / 0x0400;
+		rx_mem[sock] = RSIZE[sock] / 0x0400;
+	}
+}
+
+void
+wiz_spi_stats_reset()
+{
+	wiz_job_run_block(); // the ISRs are idle now
+
+	memset((void *)&wiz_spi_stats, 0, sizeof(Wiz_SPI_Stats));
+}
+
+void
+wiz_spi_adapt(uint_fast8_t enable)
+{
+	wiz_job_run_block(); // bus is idle now
+
+	spi_adapt = enable;
+	spi_err_burst = 0;
+	spi_clean = 0;
+
+	if(!enable) // back to the fixed clock
+		_wiz_spi_br_set(WIZ_SPI_BR_FAST);
+}
+
+uint16_t
+wiz_spi_divider()
+{
+	// of the peripheral clock, BR := 0 divides by 2
+	return 2U << ( (spi_br & SPI_CR1_BR) >> 3);
 }
 
 uint_fast8_t
@@ -406,10 +732,14 @@ wiz_subnet_set(uint8_t *subnet)
 void
 wiz_comm_set(uint8_t *mac, uint8_t *ip, uint8_t *gateway, uint8_t *subnet)
 {
-	wiz_mac_set(mac);
-	wiz_ip_set(ip);
-	wiz_gateway_set(gateway);
-	wiz_subnet_set(subnet);
+	Wiz_Burst burst = WIZ_BURST_INIT;
+
+	// GAR, SUBR, SHAR and SIPR are contiguous, a single frame
+	wiz_burst_write(&burst, WIZ_GAR, 0, gateway, 4);
+	wiz_burst_write(&burst, WIZ_SUBR, 0, subnet, 4);
+	wiz_burst_write(&burst, WIZ_SHAR, 0, mac, 6);
+	wiz_burst_write(&burst, WIZ_SIPR, 0, ip, 4);
+	wiz_burst_flush(&burst);
 }
 
 /*
@@ -428,6 +758,44 @@ udp_end(uint8_t sock)
 	while(flag != WIZ_Sn_SR_CLOSED);
 
 	wiz_socket_state[sock] = WIZ_SOCKET_STATE_CLOSED;
+	wiz_send_pending[sock] = 0;
+	send_queue_tail[sock] = send_queue_head[sock];
+	socket_gen[sock]++;
+	tcp_drop[sock] = 0;
+}
+
+static void
+_wiz_socket_port(uint8_t sock, uint16_t port)
+{
+	Wiz_Shadow *shadow = &wiz_shadow[sock];
+
+	// Sn_PORT survives closing the socket
+	if( (shadow->valid & WIZ_SHADOW_PORT) && (shadow->port == port) )
+		return;
+
+	_dma_write_sock_16(sock, WIZ_Sn_PORT, port);
+	shadow->port = port;
+	shadow->valid |= WIZ_SHADOW_PORT;
+}
+
+static void
+_wiz_socket_open(uint8_t sock, uint8_t mode)
+{
+	Wiz_Burst burst = WIZ_BURST_INIT;
+	Wiz_Shadow *shadow = &wiz_shadow[sock];
+	uint8_t flag;
+
+	shadow->mr = mode;
+	shadow->valid |= WIZ_SHADOW_MR;
+	shadow->valid &= ~WIZ_SHADOW_DST; // reconnected TCP sockets overwrite them
+
+	// Sn_MR, Sn_CR and Sn_IR are contiguous, mode is latched before the command
+	_burst_write_sock(&burst, sock, WIZ_Sn_MR, &mode, 1);
+	flag = WIZ_Sn_CR_OPEN;
+	_burst_write_sock(&burst, sock, WIZ_Sn_CR, &flag, 1);
+	flag = 0xff; // clear all flags
+	_burst_write_sock(&burst, sock, WIZ_Sn_IR, &flag, 1);
+	wiz_burst_flush(&burst);
 }
 
 void
@@ -438,22 +806,11 @@ udp_begin(uint8_t sock, uint16_t port, uint_fast8_t multicast)
 	// first close socket
 	udp_end(sock);
 
-	// clear socket interrupt register
-	_dma_write_sock(sock, WIZ_Sn_IR, &flag, 1);
-
-	// set socket mode to UDP
-	if(multicast)
-		flag = WIZ_Sn_MR_UDP | WIZ_Sn_MR_MULTI;
-	else
-		flag = WIZ_Sn_MR_UDP;
-	_dma_write_sock(sock, WIZ_Sn_MR, &flag, 1);
-
 	// set outgoing port
-	_dma_write_sock_16(sock, WIZ_Sn_PORT, port);
+	_wiz_socket_port(sock, port);
 
-	// open socket
-	flag = WIZ_Sn_CR_OPEN;
-	_dma_write_sock(sock, WIZ_Sn_CR, &flag, 1);
+	// set socket mode to UDP, open socket and clear socket interrupt register in one frame
+	_wiz_socket_open(sock, multicast ? WIZ_Sn_MR_UDP | WIZ_Sn_MR_MULTI : WIZ_Sn_MR_UDP);
 	do
 		_dma_read_sock(sock, WIZ_Sn_SR, &flag, 1);
 	while(flag != WIZ_Sn_SR_UDP);
@@ -466,11 +823,16 @@ udp_begin(uint8_t sock, uint16_t port, uint_fast8_t multicast)
 inline __always_inline void
 udp_update_read_write_pointers(uint8_t sock)
 {
-	// get write pointer
-	_dma_read_sock_16(sock, WIZ_Sn_TX_WR, &Sn_Tx_WR[sock]);
+	uint8_t ptr [6];
+
+	// get write and read pointer in one frame, Sn_TX_WR..Sn_RX_RD
+	_dma_read_sock(sock, WIZ_Sn_TX_WR, ptr, WIZ_Sn_RX_RD + 2 - WIZ_Sn_TX_WR);
+	Sn_Tx_WR[sock] = (ptr[0] << 8) | ptr[1];
+	Sn_Rx_RD[sock] = (ptr[WIZ_Sn_RX_RD - WIZ_Sn_TX_WR] << 8) | ptr[WIZ_Sn_RX_RD - WIZ_Sn_TX_WR + 1];
 
-	// get read pointer
-	_dma_read_sock_16(sock, WIZ_Sn_RX_RD, &Sn_Rx_RD[sock]);
+	// nothing queued beyond the chip's pointer
+	send_queue_tail[sock] = send_queue_head[sock];
+	send_queue_base[sock] = Sn_Tx_WR[sock];
 }
 
 inline __always_inline void
@@ -499,6 +861,13 @@ wiz_is_multicast(uint8_t *ip)
 void
 udp_set_remote(uint8_t sock, uint8_t *ip, uint16_t port)
 {
+	Wiz_Burst burst = WIZ_BURST_INIT;
+	Wiz_Shadow *shadow = &wiz_shadow[sock];
+
+	// most calls re-set the current destination
+	if( (shadow->valid & WIZ_SHADOW_DST) && (shadow->dport == port) && !memcmp(shadow->dipr, ip, 4) )
+		return;
+
 	if(wiz_is_multicast(ip))
 	{
 		uint8_t multicast_mac [6];
@@ -511,19 +880,38 @@ udp_set_remote(uint8_t sock, uint8_t *ip, uint16_t port)
 		multicast_mac[4] = ip[2] & 0xff;
 		multicast_mac[5] = ip[3] & 0xff;
 
-		udp_set_remote_har(sock, multicast_mac);
+		// remote hardware address, Sn_DHAR..Sn_DPORT are contiguous
+		_burst_write_sock(&burst, sock, WIZ_Sn_DHAR, multicast_mac, 6);
 	}
 
 	// set remote ip
-	_dma_write_sock(sock, WIZ_Sn_DIPR, ip, 4);
+	_burst_write_sock(&burst, sock, WIZ_Sn_DIPR, ip, 4);
 
 	// set remote port
-	_dma_write_sock_16(sock, WIZ_Sn_DPORT, port);
+	_burst_write_sock_16(&burst, sock, WIZ_Sn_DPORT, port);
+
+	wiz_burst_flush(&burst);
+
+	if( (shadow->valid & WIZ_SHADOW_MR) && ( (shadow->mr & 0x0f) != WIZ_Sn_MR_TCP) )
+	{
+		memcpy(shadow->dipr, ip, 4);
+		shadow->dport = port;
+		shadow->valid |= WIZ_SHADOW_DST;
+	}
 }
 
 void
 udp_get_remote(uint8_t sock, uint8_t *ip, uint16_t *port)
 {
+	Wiz_Shadow *shadow = &wiz_shadow[sock];
+
+	if(shadow->valid & WIZ_SHADOW_DST)
+	{
+		memcpy(ip, shadow->dipr, 4);
+		*port = shadow->dport;
+		return;
+	}
+
 	// get remote ip
 	_dma_read_sock(sock, WIZ_Sn_DIPR, ip, 4);
 
@@ -534,6 +922,8 @@ udp_get_remote(uint8_t sock, uint8_t *ip, uint16_t *port)
 void 
 udp_set_remote_har(uint8_t sock, uint8_t *har)
 {
+	wiz_shadow[sock].valid &= ~WIZ_SHADOW_DST; // next udp_set_remote writes the address anew
+
 	// remote hardware address, e.g. needed for UDP multicast
 	_dma_write_sock(sock, WIZ_Sn_DHAR, har, 6);
 }
@@ -549,6 +939,10 @@ udp_send_block(uint8_t sock)
 {
 	wiz_job_run_block();
 
+	// completion is signaled via SEND_OK IRQ, see udp_send_wait
+	if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+		return;
+
 	uint8_t ir;
 	uint8_t flag;
 	do
@@ -565,6 +959,86 @@ udp_send_block(uint8_t sock)
 	_dma_write_sock(sock, WIZ_Sn_IR, &flag, 1);
 }
 
+void __CCM_TEXT__
+udp_send_wait(uint8_t sock)
+{
+	wiz_job_run_block();
+
+	// handle IRQs until the previous SEND and all queued ones on this socket have completed
+	while(wiz_send_pending[sock] || (send_queue_tail[sock] != send_queue_head[sock]) )
+		if(pin_read_bit(UDP_INT) == 0)
+			wiz_irq_handle();
+}
+
+static inline uint16_t
+_udp_queue_free(uint8_t sock)
+{
+	// local mirror of Sn_TX_FSR, saves reading it over SPI for every frame
+	return SSIZE[sock] - (uint16_t)(Sn_Tx_WR[sock] - send_queue_base[sock]);
+}
+
+uint_fast8_t __CCM_TEXT__
+udp_queue_nonblocking(uint8_t sock, uint8_t *o_buf, uint16_t len)
+{
+	// without SEND_OK IRQ there is nothing to chain the queued SENDs
+	if(!(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK))
+		return udp_send_nonblocking(sock, o_buf, len);
+
+	// o_buf of the frame before last may be overwritten after this
+	wiz_job_run_block();
+
+	if(send_queue_tail[sock] == send_queue_head[sock])
+	{
+		// a plain SEND of unknown size may be in flight
+		udp_send_wait(sock);
+		send_queue_base[sock] = Sn_Tx_WR[sock];
+	}
+
+	// handle IRQs until there is a free slot and enough TX memory
+	while( ( ( (send_queue_head[sock] + 1) & WIZ_SEND_QUEUE_MASK) == send_queue_tail[sock])
+			|| (_udp_queue_free(sock) < len) )
+		if(pin_read_bit(UDP_INT) == 0)
+			wiz_irq_handle();
+
+	// data beyond the pointer of the in-flight SEND is not touched by it
+	if(!udp_append_nonblocking(sock, o_buf, len, 0))
+		return 0;
+
+	send_queue[sock][send_queue_head[sock]] = Sn_Tx_WR[sock];
+	send_queue_head[sock] = (send_queue_head[sock] + 1) & WIZ_SEND_QUEUE_MASK;
+
+	if(!wiz_send_pending[sock]) // else chained from wiz_irq_handle
+	{
+		_udp_send_cmd(sock, send_queue[sock][send_queue_tail[sock]]);
+		wiz_job_run_nonblocking();
+	}
+
+	return 1;
+}
+
+static void
+_udp_queue_done(uint8_t sock, uint_fast8_t failed)
+{
+	if(send_queue_tail[sock] == send_queue_head[sock])
+		return;
+
+	if(failed) // socket gone, drop the rest
+	{
+		send_queue_tail[sock] = send_queue_head[sock];
+		return;
+	}
+
+	send_queue_base[sock] = send_queue[sock][send_queue_tail[sock]];
+	send_queue_tail[sock] = (send_queue_tail[sock] + 1) & WIZ_SEND_QUEUE_MASK;
+
+	// issue the next queued SEND back to back
+	if(send_queue_tail[sock] != send_queue_head[sock])
+	{
+		_udp_send_cmd(sock, send_queue[sock][send_queue_tail[sock]]);
+		wiz_job_run_nonblocking();
+	}
+}
+
 inline __always_inline void
 udp_send(uint8_t sock, uint8_t *o_buf, uint16_t len)
 {
@@ -590,24 +1064,59 @@ udp_receive(uint8_t sock, uint8_t *i_buf, uint16_t len)
 void __CCM_TEXT__
 udp_dispatch(uint8_t sock, uint8_t *i_buf, Wiz_UDP_Dispatch_Cb cb)
 {
-	uint16_t len;
+	uint8_t *tmp_buf_i_ptr = i_buf + WIZ_SEND_OFFSET;
+	uint16_t len = udp_available(sock);
+	uint8_t gen = socket_gen[sock];
 
-	while( (len = udp_available(sock)) )
+	while(len)
 	{
-		// read UDP header
-		udp_receive(sock, i_buf, 8);
+		// read as many queued datagrams as fit in one go, the chip side handles the ring wrap
+		uint16_t span = len < UDP_BULK_MAX ? len : UDP_BULK_MAX;
+		udp_peek(sock, i_buf, span);
 
-		uint8_t *tmp_buf_i_ptr = i_buf + WIZ_SEND_OFFSET;
+		// find complete datagrams, each one is preceded by an 8 byte UDP header
+		uint16_t pos = 0;
+		while(pos + 8 <= span)
+		{
+			uint16_t size =(tmp_buf_i_ptr[pos+6] << 8) | tmp_buf_i_ptr[pos+7];
+			if(pos + 8 + size > span)
+				break;
+			pos += 8 + size;
+		}
 
-		uint8_t ip[4];
-		memcpy(ip, tmp_buf_i_ptr, 4);
-		uint16_t port =(tmp_buf_i_ptr[4] << 8) | tmp_buf_i_ptr[5];
-		uint16_t size =(tmp_buf_i_ptr[6] << 8) | tmp_buf_i_ptr[7];
+		if(pos == 0) // single datagram bigger than our buffer, drop it
+		{
+			uint16_t size =(tmp_buf_i_ptr[6] << 8) | tmp_buf_i_ptr[7];
+			udp_skip(sock, 8 + size);
+			len = len > 8 + size ? len - 8 - size : udp_available(sock);
+			continue;
+		}
 
-		// read UDP payload
-		udp_receive(sock, i_buf, size);
+		// commit the read pointer once, before the callbacks may touch the socket
+		udp_skip(sock, pos);
 
-		cb(ip, port, tmp_buf_i_ptr, size);
+		uint16_t end = pos;
+		for(pos=0; pos<end; )
+		{
+			uint8_t *hdr = tmp_buf_i_ptr + pos;
+			uint8_t ip[4];
+			memcpy(ip, hdr, 4);
+			uint16_t port =(hdr[4] << 8) | hdr[5];
+			uint16_t size =(hdr[6] << 8) | hdr[7];
+
+			cb(ip, port, hdr + 8, size);
+			pos += 8 + size;
+		}
+
+		// Sn_RX_RSR only grows, only re-read it once the known datagrams are consumed,
+		// or when a callback closed or reopened the socket, which resets it
+		if(socket_gen[sock] != gen)
+		{
+			gen = socket_gen[sock];
+			len = udp_available(sock);
+		}
+		else
+			len = len > end ? len - end : udp_available(sock);
 	}
 }
 
@@ -623,23 +1132,14 @@ tcp_begin(uint8_t sock, uint16_t port, uint_fast8_t server)
 	// first close socket
 	tcp_end(sock);
 
-	// clear socket interrupt register
-	_dma_write_sock(sock, WIZ_Sn_IR, &flag, 1);
-
-	// set socket mode to UDP
-	flag = WIZ_Sn_MR_TCP | WIZ_Sn_MR_ND; // TCP ACK with NoDelay
-	_dma_write_sock(sock, WIZ_Sn_MR, &flag, 1);
-
 	//flag = 20; // 1ms
 	//_dma_write(WIZ_RTR, 0, &flag, 1);
 
 	// set outgoing port
-	_dma_write_sock_16(sock, WIZ_Sn_PORT, port);
-
+	_wiz_socket_port(sock, port);
 
-	// open socket
-	flag = WIZ_Sn_CR_OPEN;
-	_dma_write_sock(sock, WIZ_Sn_CR, &flag, 1);
+	// set socket mode to TCP, open socket and clear socket interrupt register in one frame
+	_wiz_socket_open(sock, WIZ_Sn_MR_TCP | WIZ_Sn_MR_ND); // TCP ACK with NoDelay
 	do
 		_dma_read_sock(sock, WIZ_Sn_SR, &flag, 1);
 	while(flag != WIZ_Sn_SR_INIT);
@@ -671,6 +1171,10 @@ tcp_end(uint8_t sock)
 	while( (flag != WIZ_Sn_SR_CLOSED) && (flag != WIZ_Sn_SR_LISTEN) ); // after a client disconnect, server goes automatically to listening mode
 	
 	wiz_socket_state[sock] = WIZ_SOCKET_STATE_CLOSED;
+	wiz_send_pending[sock] = 0;
+	send_queue_tail[sock] = send_queue_head[sock];
+	socket_gen[sock]++;
+	tcp_drop[sock] = 0;
 }
 
 inline __always_inline void
@@ -685,6 +1189,10 @@ tcp_send_block(uint8_t sock)
 {
 	wiz_job_run_block();
 
+	// completion is signaled via SEND_OK IRQ, see udp_send_wait
+	if(irq_socket_mask[sock] & WIZ_Sn_IR_SEND_OK)
+		return;
+
 	uint8_t ir;
 	uint8_t sr;
 	uint8_t flag;
@@ -706,48 +1214,85 @@ tcp_send_block(uint8_t sock)
 void //__CCM_TEXT__
 tcp_dispatch(uint8_t sock, uint8_t *i_buf, Wiz_UDP_Dispatch_Cb cb, uint8_t slip)
 {
-	uint16_t len;
+	uint8_t *tmp_buf_i_ptr = i_buf + WIZ_SEND_OFFSET;
+	uint16_t len = tcp_available(sock);
+	uint8_t gen = socket_gen[sock];
 
+	if(!len)
+		return;
+
+	// the chip sets the remote address of a connected TCP socket
 	uint8_t ip [4];
 	uint16_t port;
+	udp_get_remote(sock, ip, &port);
 
-	if(!slip)
+	while(len)
 	{
-		while( (len = tcp_available(sock)) )
-		{
-			// read OSC packet size
-			tcp_receive(sock, i_buf, 4);
+		uint16_t span = len < UDP_BULK_MAX ? len : UDP_BULK_MAX;
+		uint16_t pos = 0;
 
-			uint8_t *tmp_buf_i_ptr = i_buf + WIZ_SEND_OFFSET;
-			int32_t size = ref_ntohl(tmp_buf_i_ptr);
-
-			if(len - 4 < size)
-				while(tcp_available(sock) < size)
-					; // wait for complete OSC packet
+		if(tcp_drop[sock])
+		{
+			pos = tcp_drop[sock] < span ? tcp_drop[sock] : span;
+			tcp_drop[sock] -= pos;
+			tcp_skip(sock, pos);
+			len -= pos;
+			continue;
+		}
 
-			// read TCP payload
-			tcp_receive(sock, i_buf, size);
+		// one read for all buffered packets, they are parsed in place
+		tcp_peek(sock, i_buf, span);
 
-			cb(ip, port, tmp_buf_i_ptr, size);
+		if(!slip)
+		{
+			while(pos + 4 <= span)
+			{
+				// OSC packet size prefix, untrusted, compare before any addition may wrap
+				uint32_t size = ref_ntohl(tmp_buf_i_ptr + pos);
+
+				if(size > UDP_BULK_MAX - 4) // would never fit, stream it to nowhere
+				{
+					if(pos == 0)
+						tcp_drop[sock] = size < 0xfffffffc ? size + 4 : 0xffffffff;
+					break;
+				}
+				if(pos + 4 + size > span) // incomplete, wait for the rest
+					break;
+
+				cb(ip, port, tmp_buf_i_ptr + pos + 4, size);
+				pos += 4 + size;
+
+				if(socket_gen[sock] != gen) // callback closed or reopened the socket
+					return;
+			}
 		}
-	}
-	else // slip
-	{
-		while( (len = tcp_available(sock)) )
+		else // slip
 		{
-			// peek all
-			tcp_peek(sock, i_buf, len);
-
-			uint8_t *tmp_buf_i_ptr = i_buf + WIZ_SEND_OFFSET;
 			size_t size;
-			size_t parsed = slip_decode(tmp_buf_i_ptr, len, &size);
-			if(parsed > 0)
+			size_t parsed;
+
+			while( (pos < span) && (parsed = slip_decode(tmp_buf_i_ptr + pos, span - pos, &size)) )
 			{
 				if(size > 0)
-					cb(ip, port, tmp_buf_i_ptr, size);
-				tcp_skip(sock, parsed);
+					cb(ip, port, tmp_buf_i_ptr + pos, size);
+				pos += parsed;
+
+				if(socket_gen[sock] != gen) // callback closed or reopened the socket
+					return;
 			}
+
+			if( (pos == 0) && (span == UDP_BULK_MAX) ) // frame would never fit, skip to its end
+				pos = span;
 		}
+
+		if(tcp_drop[sock])
+			continue;
+		if(pos == 0) // incomplete, the next RECV IRQ brings the rest
+			break;
+
+		// release the read pointer only now that dispatch of the packets is complete
+		tcp_skip(sock, pos);
+		len = len > pos ? len - pos : tcp_available(sock);
 	}
 }
 
@@ -772,6 +1317,14 @@ osc_send_nonblocking(OSC_Config *osc, uint8_t *o_buf, uint16_t len)
 		return udp_send_nonblocking(osc->socket.sock, o_buf, len);
 }
 
+void
+osc_sendv(OSC_Config *osc, const Wiz_Vec *vec, uint_fast8_t n)
+{
+	// tcp_sendv_nonblocking is an alias, the block differs
+	if(udp_sendv_nonblocking(osc->socket.sock, vec, n))
+		osc_send_block(osc);
+}
+
 void
 osc_send_block(OSC_Config *osc)
 {
@@ -802,19 +1355,11 @@ macraw_begin(uint8_t sock, uint_fast8_t mac_filter)
 	// first close socket
 	macraw_end(sock);
 
-	// clear socket interrupt register
-	_dma_write_sock(sock, WIZ_Sn_IR, &flag, 1);
-
-	// set socket mode to MACRAW
+	// set socket mode to MACRAW, open socket and clear socket interrupt register in one frame
 	if(mac_filter) // only look for packages addressed to our MAC or broadcast
-		flag = WIZ_Sn_MR_MACRAW | WIZ_Sn_MR_MF;
+		_wiz_socket_open(sock, WIZ_Sn_MR_MACRAW | WIZ_Sn_MR_MF);
 	else
-		flag = WIZ_Sn_MR_MACRAW;
-	_dma_write_sock(sock, WIZ_Sn_MR, &flag, 1);
-
-	// open socket
-	flag = WIZ_Sn_CR_OPEN;
-	_dma_write_sock(sock, WIZ_Sn_CR, &flag, 1);
+		_wiz_socket_open(sock, WIZ_Sn_MR_MACRAW);
 	do _dma_read_sock(sock, WIZ_Sn_SR, &flag, 1);
 	while(flag != WIZ_Sn_SR_MACRAW)
 		;
@@ -869,6 +1414,11 @@ wiz_irq_handle(void)
 			{
 				uint8_t sock_ir;
 				_dma_read_sock(sock, WIZ_Sn_IR, &sock_ir, 1); // get socket IRQ
+				if(sock_ir & (WIZ_Sn_IR_SEND_OK | WIZ_Sn_IR_TIMEOUT | WIZ_Sn_IR_DISCON))
+				{
+					wiz_send_pending[sock] = 0; // in-flight SEND has completed or failed
+					_udp_queue_done(sock, sock_ir & WIZ_Sn_IR_DISCON);
+				}
 				irq_socket_cb[sock](sock_ir);
 				_dma_write_sock(sock, WIZ_Sn_IR, &sock_ir, 1); // clear socket IRQ flags(this automatically clears WIZ_SIR[sock]
 			}
@@ -882,6 +1432,7 @@ wiz_irq_set(Wiz_IRQ_Cb cb, uint8_t mask)
 	irq_cb = cb;
 
 	_dma_write(WIZ_IMR, 0, &mask , 1); // set mask
+	wiz_imr_shadow = mask;
 }
 
 void
@@ -891,31 +1442,52 @@ wiz_irq_unset()
 
 	uint8_t mask = 0;
 	_dma_write(WIZ_IMR, 0, &mask , 1); // clear mask
+	wiz_imr_shadow = mask;
+}
+
+static void
+_wiz_socket_imr(uint8_t socket, uint8_t mask)
+{
+	Wiz_Shadow *shadow = &wiz_shadow[socket];
+
+	if( (shadow->valid & WIZ_SHADOW_IMR) && (shadow->imr == mask) )
+		return;
+
+	_dma_write_sock(socket, WIZ_Sn_IMR, &mask, 1);
+	shadow->imr = mask;
+	shadow->valid |= WIZ_SHADOW_IMR;
 }
 
 void
 wiz_socket_irq_set(uint8_t socket, Wiz_IRQ_Cb cb, uint8_t mask)
 {
 	irq_socket_cb[socket] = cb;
+	irq_socket_mask[socket] = mask;
 
-	uint8_t mask2;
-	_dma_read(WIZ_SIMR, 0, &mask2, 1);
-	mask2 |=(1U << socket); // enable socket IRQs
-	_dma_write(WIZ_SIMR, 0, &mask2, 1);
+	uint8_t mask2 = wiz_simr_shadow |(1U << socket); // enable socket IRQs
+	if(mask2 != wiz_simr_shadow)
+	{
+		_dma_write(WIZ_SIMR, 0, &mask2, 1);
+		wiz_simr_shadow = mask2;
+	}
 
-	_dma_write_sock(socket, WIZ_Sn_IMR, &mask, 1); // set mask
+	_wiz_socket_imr(socket, mask); // set mask
 }
 
 void
 wiz_socket_irq_unset(uint8_t socket)
 {
 	irq_socket_cb[socket] = NULL;
+	irq_socket_mask[socket] = 0;
+	wiz_send_pending[socket] = 0;
+	send_queue_tail[socket] = send_queue_head[socket];
 
-	uint8_t mask2;
-	_dma_read(WIZ_SIMR, 0, &mask2, 1);
-	mask2 &= ~(1U << socket); // disable socket IRQs
-	_dma_write(WIZ_SIMR, 0, &mask2, 1);
+	uint8_t mask2 = wiz_simr_shadow & ~(1U << socket); // disable socket IRQs
+	if(mask2 != wiz_simr_shadow)
+	{
+		_dma_write(WIZ_SIMR, 0, &mask2, 1);
+		wiz_simr_shadow = mask2;
+	}
 
-	uint8_t mask = 0;
-	_dma_write_sock(socket, WIZ_Sn_IMR, &mask, 1); // clear mask
+	_wiz_socket_imr(socket, 0); // clear mask
 }
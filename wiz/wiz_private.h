@@ -29,9 +29,13 @@
 enum {
 	WIZ_TX		= 1,
 	WIZ_RX		= 2,
-	WIZ_TXRX	= 3
+	WIZ_TXRX	= 3,
+	WIZ_TXV		= 5  // scatter-gather TX, header from job, segments back-to-back
 };
 
+#define UDP_BULK_MAX (CHIMAERA_BUFSIZE - WIZ_SEND_OFFSET) // udp_dispatch reads up to this many queued bytes at once
+#define WIZ_BURST_MAX 24 // covers GAR..SIPR and Sn_MR..Sn_DPORT
+
 typedef struct _Wiz_Job Wiz_Job;
 
 struct _Wiz_Job {
@@ -42,19 +46,83 @@ struct _Wiz_Job {
 	uint8_t opmode; // only for W5500
 	uint8_t rw;
 	uint8_t rx_hdr_sent;
+	uint8_t retry; // failed attempts so far
+	uint8_t vec_n; // WIZ_TXV only
+	uint8_t vec_i; // segment in flight, 0 := header
+	uint8_t hdr [WIZ_SEND_OFFSET];
+	Wiz_Vec vec [WIZ_MAX_VEC_NUM];
 };
 
 void wiz_job_add(uint16_t addr, uint16_t len, uint8_t *tx, uint8_t *rx, uint8_t opmode, uint8_t rw);
+void wiz_job_add_sg(uint16_t addr, const Wiz_Vec *vec, uint_fast8_t n, uint8_t opmode);
 void wiz_job_set_frame();
 void wiz_job_run_single();
 void wiz_job_run_nonblocking();
 void wiz_job_run_block();
 
-#define WIZ_MAX_JOB_NUM 8
+#define WIZ_MAX_JOB_NUM 16 // power of two
+#define WIZ_JOB_MASK (WIZ_MAX_JOB_NUM - 1)
 
+/*
+ * single-producer/single-consumer ring, the main loop appends at head,
+ * the SPI DMA ISRs run the job at tail and chain the next one until empty
+ */
 extern Wiz_Job wiz_jobs [WIZ_MAX_JOB_NUM];
-extern volatile uint_fast8_t wiz_jobs_todo;
-extern volatile uint_fast8_t wiz_jobs_done;
+extern volatile uint_fast8_t wiz_jobs_head; // written by the main loop only
+extern volatile uint_fast8_t wiz_jobs_tail; // written by the DMA ISRs only
+extern volatile uint_fast8_t wiz_jobs_busy; // a DMA chain is running
+
+// job is complete before the ISRs can see it
+#if defined(__ARM_ARCH_7EM__)
+#	define wiz_dmb() asm volatile("\tdmb\n" ::: "memory")
+#else
+#	define wiz_dmb() __sync_synchronize()
+#endif
+
+typedef struct _Wiz_Shadow Wiz_Shadow;
+
+enum {
+	WIZ_SHADOW_MR		= (1U << 0),
+	WIZ_SHADOW_PORT	= (1U << 1),
+	WIZ_SHADOW_DST	= (1U << 2), // Sn_DIPR and Sn_DPORT, UDP only, the chip sets them for TCP
+	WIZ_SHADOW_IMR	= (1U << 3),
+	WIZ_SHADOW_BUF	= (1U << 4)
+};
+
+// RAM copy of registers only the firmware writes, status registers are never cached
+struct _Wiz_Shadow {
+	uint8_t valid;
+	uint8_t mr;
+	uint16_t port;
+	uint8_t dipr [4];
+	uint16_t dport;
+	uint8_t imr;
+	uint8_t tx_mem;
+	uint8_t rx_mem;
+};
+
+extern uint8_t wiz_imr_shadow;
+extern uint8_t wiz_simr_shadow;
+extern Wiz_Shadow wiz_shadow [WIZ_MAX_SOCK_NUM];
+
+void wiz_shadow_invalidate();
+
+void _udp_send_cmd(uint8_t sock, uint16_t ptr);
+
+/*
+ * adaptive SPI clock, a burst of errors within a window of transactions
+ * halves it, a long run of clean transactions doubles it again
+ */
+#define WIZ_SPI_BR_FAST SPI_CR1_BR_PCLK_DIV_2
+#define WIZ_SPI_BR_SLOW SPI_CR1_BR_PCLK_DIV_16
+#define WIZ_SPI_BR_STEP SPI_CR1_BR_PCLK_DIV_4 // one power of two
+#define WIZ_SPI_ERR_BURST 4
+#define WIZ_JOB_RETRY_MAX 3 // attempts before an erroneous job is dropped
+#define WIZ_SPI_ERR_WINDOW 256
+#define WIZ_SPI_CLEAN_RUN 0x8000
+
+#define WIZ_SEND_QUEUE_NUM 8 // power of two
+#define WIZ_SEND_QUEUE_MASK (WIZ_SEND_QUEUE_NUM - 1)
 
 extern gpio_dev *ss_dev;
 extern uint8_t ss_bit;
@@ -63,6 +131,9 @@ extern uint8_t ss_bit;
 
 extern Wiz_IRQ_Cb irq_cb;
 extern Wiz_IRQ_Cb irq_socket_cb [WIZ_MAX_SOCK_NUM];
+extern uint8_t irq_socket_mask [WIZ_MAX_SOCK_NUM];
+
+extern volatile uint_fast8_t wiz_send_pending [WIZ_MAX_SOCK_NUM];
 
 extern uint16_t SSIZE [WIZ_MAX_SOCK_NUM];
 extern uint16_t RSIZE [WIZ_MAX_SOCK_NUM];
@@ -77,6 +148,23 @@ void _dma_write(uint16_t addr, uint8_t cntrl, uint8_t *dat, uint16_t len);
 void _dma_write_sock(uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len);
 void _dma_write_sock_16(uint8_t sock, uint16_t addr, uint16_t dat);
 
+typedef struct _Wiz_Burst Wiz_Burst;
+
+// register writes to adjacent addresses of the same block, sent as one frame
+struct _Wiz_Burst {
+	uint16_t addr;
+	uint8_t cntrl; // only for W5500
+	uint8_t len;
+	uint8_t buf [WIZ_BURST_MAX];
+};
+
+#define WIZ_BURST_INIT {.len = 0}
+
+void wiz_burst_write(Wiz_Burst *burst, uint16_t addr, uint8_t cntrl, uint8_t *dat, uint16_t len);
+void wiz_burst_flush(Wiz_Burst *burst);
+void _burst_write_sock(Wiz_Burst *burst, uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len);
+void _burst_write_sock_16(Wiz_Burst *burst, uint8_t sock, uint16_t addr, uint16_t dat);
+
 void _dma_read(uint16_t addr, uint8_t cntrl, uint8_t *dat, uint16_t len);
 void _dma_read_sock(uint8_t sock, uint16_t addr, uint8_t *dat, uint16_t len);
 void _dma_read_sock_16(int8_t sock, uint16_t addr, uint16_t *dat);